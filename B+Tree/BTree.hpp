@@ -1,19 +1,839 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <cstddef>
 #include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <type_traits>
+#include <utility>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include "exception.hpp"
 #include "utility.hpp"
 
 namespace sjtu
 {
+    enum OpenMode
+    {
+        ReadWrite,
+        // NOTE: shared by many processes, never writes
+        //  a builder publishes a new version by rename() over file_path
+        ReadOnly,
+    };
+
+    // >>>>> hash of a key, see HotCache
+    //  equal keys have equal hashes, h is the hash of what came before
+    //  a scalar is hashed by its bytes, any other Key by its hash(h),
+    //  which combines hashKey() of its fields,
+    //  since the bytes of a struct may include padding
+    const unsigned long long HASH_SEED = 0x9e3779b97f4a7c15ULL;
+
+    inline unsigned long long hashBytes(const void *ptr, size_t n, unsigned long long h)
+    {
+        const unsigned char *bytes = (const unsigned char *)ptr;
+        for (size_t i = 0; i < n; i += 8)
+        {
+            unsigned long long word = 0;
+            memcpy(&word, bytes + i, n - i < 8 ? n - i : 8);
+            h = (h ^ word) * 0xff51afd7ed558ccdULL;
+            h ^= h >> 32;
+        }
+        return h;
+    }
+
+    template <class Key>
+    typename std::enable_if<std::is_scalar<Key>::value, unsigned long long>::type
+    hashKey(const Key &key, unsigned long long h = HASH_SEED)
+    {
+        // -0.0 == 0.0
+        Key x = key == Key() ? Key() : key;
+        return hashBytes(&x, sizeof(Key), h);
+    }
+
+    template <class Key>
+    auto hashKey(const Key &key, unsigned long long h = HASH_SEED) -> decltype(key.hash(h))
+    {
+        return key.hash(h);
+    }
+
+    // whether hashKey(Key) is defined
+    template <class Key, class = void>
+    struct IsHashable : std::is_scalar<Key>
+    {
+    };
+    template <class Key>
+    struct IsHashable<Key, decltype((void)std::declval<const Key &>().hash(HASH_SEED))>
+        : std::true_type
+    {
+    };
+
+    // string key of at most N chars, stored in place and zero padded
+    //  ordered as strcmp, so prefix P is the least key starting with P
+    template <int N>
+    struct FixedString
+    {
+        char data[N];
+
+        FixedString() { memset(data, 0, N); }
+        FixedString(const char *s)
+        {
+            int len = strnlen(s, N);
+            memcpy(data, s, len);
+            memset(data + len, 0, N - len);
+        }
+
+        int length() const { return strnlen(data, N); }
+
+        unsigned long long hash(unsigned long long h) const { return hashBytes(data, N, h); }
+
+        bool startsWith(const char *prefix, int len) const
+        {
+            return len <= N && memcmp(data, prefix, len) == 0;
+        }
+
+        bool operator<(const FixedString &rhs) const { return memcmp(data, rhs.data, N) < 0; }
+        bool operator>(const FixedString &rhs) const { return memcmp(data, rhs.data, N) > 0; }
+        bool operator<=(const FixedString &rhs) const { return memcmp(data, rhs.data, N) <= 0; }
+        bool operator>=(const FixedString &rhs) const { return memcmp(data, rhs.data, N) >= 0; }
+        bool operator==(const FixedString &rhs) const { return memcmp(data, rhs.data, N) == 0; }
+        bool operator!=(const FixedString &rhs) const { return memcmp(data, rhs.data, N) != 0; }
+    };
+
+    // >>>>> in-node search policy
+    //  find(key, n, target, model)
+    //      returns: k, key[k - 1] < target <= key[k]
+    //  fit(key, n, model)
+    //      called before a page is saved, to fill in its model
+
+    // k ~= intercept + slope * (target - key[0]), |error| <= max_error
+    // NOTE: models may be out of date, so a prediction is always verified
+    struct PageModel
+    {
+        float slope, intercept;
+        int max_error;
+    };
+
+    struct LinearSearch
+    {
+        template <class Key, class K>
+        static int find(const Key *key, int n, const K &target, const PageModel &)
+        {
+            int k = 0;
+            while (k < n && target > key[k])
+                k++;
+            return k;
+        }
+
+        template <class Key>
+        static void fit(const Key *, int, PageModel &) {}
+    };
+
+    struct BinarySearch
+    {
+        // NOTE: key[lo - 1] < target <= key[hi]
+        template <class Key, class K>
+        static int lowerBound(const Key *key, int lo, int hi, const K &target)
+        {
+            while (lo < hi)
+            {
+                int mid = (lo + hi) >> 1;
+                if (target > key[mid])
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+        template <class Key, class K>
+        static int find(const Key *key, int n, const K &target, const PageModel &)
+        {
+            return lowerBound(key, 0, n, target);
+        }
+
+        template <class Key>
+        static void fit(const Key *, int, PageModel &) {}
+    };
+
+    // for arithmetic keys
+    //  guess by interpolation, then gallop to a bounded binary search
+    struct InterpolationSearch
+    {
+        template <class Key, class K>
+        static int find(const Key *key, int n, const K &target, const PageModel &)
+        {
+            if (n == 0 || !(target > key[0]))
+                return 0;
+            if (target > key[n - 1])
+                return n;
+            int k = ((double)target - key[0]) / ((double)key[n - 1] - key[0]) * (n - 1);
+            k = k < 1 ? 1 : k > n - 1 ? n - 1 : k;
+            int lo, hi, step = 1;
+            if (target > key[k])
+            {
+                // key[k] < target <= key[n - 1]
+                while (k + step < n - 1 && target > key[k + step])
+                    step <<= 1;
+                lo = k + 1, hi = k + step < n - 1 ? k + step : n - 1;
+            }
+            else
+            {
+                // key[0] < target <= key[k]
+                while (k - step > 0 && !(target > key[k - step]))
+                    step <<= 1;
+                lo = k - step > 0 ? k - step + 1 : 1, hi = k;
+            }
+            return BinarySearch::lowerBound(key, lo, hi, target);
+        }
+
+        template <class Key>
+        static void fit(const Key *, int, PageModel &) {}
+    };
+
+    // for arithmetic keys
+    //  a per-page linear model, then a binary search within max_error
+    struct LearnedSearch
+    {
+        template <class Key, class K>
+        static int find(const Key *key, int n, const K &target, const PageModel &model)
+        {
+            if (n == 0)
+                return 0;
+            double guess = model.intercept + model.slope * ((double)target - key[0]);
+            int k = guess < 0 ? 0 : guess > n ? n : (int)guess;
+            // target lies between two keys, each within max_error
+            int lo = k - model.max_error - 1, hi = k + model.max_error + 1;
+            lo = lo < 0 ? 0 : lo > n ? n : lo;
+            hi = hi < lo ? lo : hi > n ? n : hi;
+            if ((lo > 0 && !(target > key[lo - 1])) ||
+                (hi < n && target > key[hi]))
+                lo = 0, hi = n; // out of date
+            return BinarySearch::lowerBound(key, lo, hi, target);
+        }
+
+        // least squares over (key[k] - key[0], k)
+        template <class Key>
+        static void fit(const Key *key, int n, PageModel &model)
+        {
+            double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+            for (int k = 0; k < n; ++k)
+            {
+                double x = (double)key[k] - key[0];
+                sum_x += x, sum_y += k;
+                sum_xx += x * x, sum_xy += x * k;
+            }
+            double det = n * sum_xx - sum_x * sum_x;
+            model.slope = det > 0 ? (n * sum_xy - sum_x * sum_y) / det : 0;
+            model.intercept = n > 0 ? (sum_y - model.slope * sum_x) / n : 0;
+            model.max_error = 0;
+            for (int k = 0; k < n; ++k)
+            {
+                int error = (int)(model.intercept +
+                                  model.slope * ((double)key[k] - key[0])) -
+                            k;
+                error = error < 0 ? -error : error;
+                if (error > model.max_error)
+                    model.max_error = error;
+            }
+        }
+    };
+    // <<<<< in-node search policy
+
+    // >>>>> leaf layout
+    //  how (key, value)s of a leaf are stored in its page
+    //  size(key, value, n)
+    //      returns: bytes of page
+    //  encode(key, value, n, page, page_size), decode(page, n, key, value)
+    //  key(page, k), value(page, n, k), find(page, n, target)
+    //      access a page without decoding it
+    //  isValid(page, n, page_size)
+    //      whether a page read from disk can be decoded safely
+
+    // keys and values are read and written in place, see BTree::Node
+    // NOTE: the codec is never called
+    struct PlainLeaf
+    {
+        static const bool IS_PACKED = false;
+        static const int HEADER_SIZE = 0;
+
+        template <class Key, class Value>
+        static int size(const Key *, const Value *, int) { return 0; }
+        template <class Key, class Value>
+        static bool encode(const Key *, const Value *, int, char *, int) { return true; }
+        template <class Key, class Value>
+        static void decode(const char *, int, Key *, Value *) {}
+        template <class Key>
+        static Key key(const char *, int) { return Key(); }
+        template <class Key, class Value>
+        static Value value(const char *, int, int) { return Value(); }
+        template <class Key, class K>
+        static int find(const char *, int, const K &) { return 0; }
+        static bool isValid(const char *, int, int) { return true; }
+    };
+
+    // for integral keys and values
+    //  frame of reference: key - key[0] and value - min value,
+    //  bit packed in the least width of the page
+    //  a packed key is located by k * width, so binary search needs no decoding
+    // page: Header, keys, values, 8 bytes of padding for unaligned loads
+    struct PackedLeaf
+    {
+        static const bool IS_PACKED = true;
+
+        struct Header
+        {
+            unsigned long long key_base, value_base;
+            int key_bits, value_bits;
+        };
+        static const int HEADER_SIZE = sizeof(Header) + 8;
+
+        static int width(unsigned long long x)
+        {
+            return x == 0 ? 0 : 64 - __builtin_clzll(x);
+        }
+
+        static int bytes(int n, int bits) { return ((long long)n * bits + 7) >> 3; }
+
+        // k-th integer of bits in stream
+        static unsigned long long get(const char *stream, int bits, int k)
+        {
+            long long pos = (long long)k * bits;
+            const char *p = stream + (pos >> 3);
+            int shift = pos & 7;
+            unsigned long long word;
+            memcpy(&word, p, sizeof(word));
+            word >>= shift;
+            if (bits + shift > 64)
+                word |= (unsigned long long)(unsigned char)p[8] << (64 - shift);
+            return bits == 64 ? word : word & ((1ULL << bits) - 1);
+        }
+
+        // write x[k] - base of bits one after another
+        //  returns: end of stream
+        template <class T>
+        static char *pack(char *stream, int bits, int n,
+                          const T *x, unsigned long long base)
+        {
+            unsigned long long buffer = 0;
+            int n_bit = 0; // bits in buffer
+            for (int k = 0; bits > 0 && k < n; ++k)
+            {
+                unsigned long long y = (unsigned long long)x[k] - base;
+                buffer |= y << n_bit;
+                if (n_bit + bits < 64)
+                {
+                    n_bit += bits;
+                    continue;
+                }
+                memcpy(stream, &buffer, sizeof(buffer));
+                stream += sizeof(buffer);
+                buffer = n_bit > 0 ? y >> (64 - n_bit) : 0;
+                n_bit += bits - 64;
+            }
+            memcpy(stream, &buffer, (n_bit + 7) >> 3);
+            return stream + ((n_bit + 7) >> 3);
+        }
+
+        // out[k] = base + k-th integer, 4 at a time by AVX2 gathers
+        template <class T>
+        static void unpack(const char *stream, int bits, int n,
+                           unsigned long long base, T *out)
+        {
+            int k = 0;
+#ifdef __AVX2__
+            if (bits <= 56)
+            {
+                __m256i pos = _mm256_set_epi64x(3LL * bits, 2LL * bits, bits, 0);
+                __m256i step = _mm256_set1_epi64x(4LL * bits);
+                __m256i mask = _mm256_set1_epi64x((1LL << bits) - 1);
+                __m256i seven = _mm256_set1_epi64x(7);
+                __m256i offset = _mm256_set1_epi64x(base);
+                unsigned long long word[4];
+                for (; k + 4 <= n; k += 4)
+                {
+                    __m256i x = _mm256_i64gather_epi64(
+                        (const long long *)stream, _mm256_srli_epi64(pos, 3), 1);
+                    x = _mm256_srlv_epi64(x, _mm256_and_si256(pos, seven));
+                    x = _mm256_add_epi64(_mm256_and_si256(x, mask), offset);
+                    _mm256_storeu_si256((__m256i *)word, x);
+                    out[k] = (T)word[0], out[k + 1] = (T)word[1];
+                    out[k + 2] = (T)word[2], out[k + 3] = (T)word[3];
+                    pos = _mm256_add_epi64(pos, step);
+                }
+            }
+#endif
+            // read bits one after another
+            unsigned long long buffer = 0;
+            int n_bit = 0; // bits in buffer
+            unsigned long long mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+            long long pos = (long long)k * bits;
+            stream += pos >> 3;
+            if ((pos & 7) != 0 && k < n)
+            {
+                memcpy(&buffer, stream, sizeof(buffer));
+                stream += sizeof(buffer);
+                buffer >>= pos & 7;
+                n_bit = 64 - (pos & 7);
+            }
+            for (; k < n; ++k)
+            {
+                if (n_bit >= bits)
+                {
+                    out[k] = (T)(base + (buffer & mask));
+                    buffer = bits == 64 ? 0 : buffer >> bits;
+                    n_bit -= bits;
+                    continue;
+                }
+                unsigned long long word;
+                memcpy(&word, stream, sizeof(word));
+                stream += sizeof(word);
+                out[k] = (T)(base + ((buffer | word << n_bit) & mask));
+                buffer = bits - n_bit < 64 ? word >> (bits - n_bit) : 0;
+                n_bit += 64 - bits;
+            }
+        }
+
+        template <class Key, class Value>
+        static Header header(const Key *key, const Value *value, int n)
+        {
+            static_assert(std::is_integral<Key>::value && std::is_integral<Value>::value,
+                          "PackedLeaf: integral Key and Value only");
+            Header x = Header();
+            if (n == 0)
+                return x;
+            Value min_value = value[0], max_value = value[0];
+            for (int k = 1; k < n; ++k)
+            {
+                min_value = value[k] < min_value ? value[k] : min_value;
+                max_value = value[k] > max_value ? value[k] : max_value;
+            }
+            // NOTE: differences are taken modulo 2^64
+            x.key_base = key[0], x.value_base = min_value;
+            x.key_bits = width((unsigned long long)key[n - 1] - x.key_base);
+            x.value_bits = width((unsigned long long)max_value - x.value_base);
+            return x;
+        }
+
+        template <class Key, class Value>
+        static int size(const Key *key, const Value *value, int n)
+        {
+            Header x = header(key, value, n);
+            return HEADER_SIZE + bytes(n, x.key_bits) + bytes(n, x.value_bits);
+        }
+
+        // returns: false if the page is too small
+        template <class Key, class Value>
+        static bool encode(const Key *key, const Value *value, int n,
+                           char *page, int page_size)
+        {
+            Header x = header(key, value, n);
+            if (HEADER_SIZE + bytes(n, x.key_bits) + bytes(n, x.value_bits) > page_size)
+                return false;
+            memcpy(page, &x, sizeof(Header));
+            char *stream = pack(page + sizeof(Header), x.key_bits, n, key, x.key_base);
+            stream = pack(stream, x.value_bits, n, value, x.value_base);
+            memset(stream, 0, 8);
+            return true;
+        }
+
+        template <class Key, class Value>
+        static void decode(const char *page, int n, Key *key, Value *value)
+        {
+            Header x;
+            memcpy(&x, page, sizeof(Header));
+            const char *stream = page + sizeof(Header);
+            unpack(stream, x.key_bits, n, x.key_base, key);
+            unpack(stream + bytes(n, x.key_bits), x.value_bits, n, x.value_base, value);
+        }
+
+        template <class Key>
+        static Key key(const char *page, int k)
+        {
+            Header x;
+            memcpy(&x, page, sizeof(Header));
+            return (Key)(x.key_base + get(page + sizeof(Header), x.key_bits, k));
+        }
+
+        template <class Key, class Value>
+        static Value value(const char *page, int n, int k)
+        {
+            Header x;
+            memcpy(&x, page, sizeof(Header));
+            const char *stream = page + sizeof(Header) + bytes(n, x.key_bits);
+            return (Value)(x.value_base + get(stream, x.value_bits, k));
+        }
+
+        static bool isValid(const char *page, int n, int page_size)
+        {
+            Header x;
+            memcpy(&x, page, sizeof(Header));
+            return x.key_bits >= 0 && x.key_bits <= 64 &&
+                   x.value_bits >= 0 && x.value_bits <= 64 &&
+                   HEADER_SIZE + bytes(n, x.key_bits) + bytes(n, x.value_bits) <= page_size;
+        }
+
+        // returns: k, key[k - 1] < target <= key[k]
+        template <class Key, class K>
+        static int find(const char *page, int n, const K &target)
+        {
+            Header x;
+            memcpy(&x, page, sizeof(Header));
+            const char *stream = page + sizeof(Header);
+            int lo = 0, hi = n;
+            while (lo < hi)
+            {
+                int mid = (lo + hi) >> 1;
+                if (target > (Key)(x.key_base + get(stream, x.key_bits, mid)))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+    };
+    // <<<<< leaf layout
+
+    // a counter of Stats, read as a long long
+    // NOTE: relaxed atomic, as it may be bumped by one thread while another reads it,
+    //  e.g. the writer of a ShardedBTree shard and a caller of ShardedBTree::stats()
+    //  it only counts, and orders nothing
+    class Counter
+    {
+    private:
+        std::atomic<long long> value;
+
+    public:
+        Counter(long long value = 0) : value(value) {}
+        Counter(const Counter &other) : value(other.load()) {}
+        Counter &operator=(const Counter &other)
+        {
+            value.store(other.load(), std::memory_order_relaxed);
+            return *this;
+        }
+
+        long long load() const { return value.load(std::memory_order_relaxed); }
+        operator long long() const { return load(); }
+
+        long long operator++(int) { return value.fetch_add(1, std::memory_order_relaxed); }
+        Counter &operator+=(long long n)
+        {
+            value.fetch_add(n, std::memory_order_relaxed);
+            return *this;
+        }
+    };
+
+    // I/O and structural counters of a BTree, see BTree::stats()
+    struct Stats
+    {
+        Counter page_read, page_write;
+        Counter byte_read, byte_write;
+        Counter split, rotate, merge;
+        // operations
+        //  query: at, modify, find, lower_bound and seek
+        Counter insert, erase, query;
+        // at() with a cache, see BTree::setCache()
+        //  hit_ns, miss_ns: total latency of at() served by cache / by pages
+        Counter cache_hit, cache_miss;
+        Counter hit_ns, miss_ns;
+
+        // sum of counters, e.g. over the shards of ShardedBTree
+        Stats &operator+=(const Stats &other)
+        {
+            page_read += other.page_read, page_write += other.page_write;
+            byte_read += other.byte_read, byte_write += other.byte_write;
+            split += other.split, rotate += other.rotate, merge += other.merge;
+            insert += other.insert, erase += other.erase, query += other.query;
+            cache_hit += other.cache_hit, cache_miss += other.cache_miss;
+            hit_ns += other.hit_ns, miss_ns += other.miss_ns;
+            return *this;
+        }
+
+        long long operation() const { return insert + erase + query; }
+
+        double bytePerOperation() const
+        {
+            return operation() > 0
+                       ? (double)(byte_read + byte_write) / operation()
+                       : 0;
+        }
+
+        double hitRate() const
+        {
+            return cache_hit + cache_miss > 0
+                       ? (double)cache_hit / (cache_hit + cache_miss)
+                       : 0;
+        }
+
+        // ns per at()
+        double hitLatency() const { return cache_hit > 0 ? (double)hit_ns / cache_hit : 0; }
+        double missLatency() const { return cache_miss > 0 ? (double)miss_ns / cache_miss : 0; }
+    };
+
+    // shape of a BTree, see BTree::analyze()
+    struct Analysis
+    {
+        static const int MAX_LEVEL = 16;
+        // fill[d][i]: nodes of level d with n_key / max_n_key in [i / 10, (i + 1) / 10)
+        //  a full node is counted in fill[d][N_BUCKET - 1]
+        static const int N_BUCKET = 10;
+
+        int height; // level[0] is root, level[height - 1] is leaf
+        long long n_node[MAX_LEVEL], n_key[MAX_LEVEL];
+        long long capacity[MAX_LEVEL]; // max n_key of the whole level
+        long long fill[MAX_LEVEL][N_BUCKET];
+        long long n_empty_leaf;
+        long long n_page, n_dead_page; // dead: unreachable from root
+
+        Analysis() { memset(this, 0, sizeof(Analysis)); }
+
+        void print(FILE *out = stdout) const
+        {
+            fprintf(out, "height: %d, pages: %lld (dead: %lld), empty leaves: %lld\n",
+                    height, n_page, n_dead_page, n_empty_leaf);
+            fprintf(out, "level %10s %12s %6s  fill histogram (10%% buckets)\n",
+                    "nodes", "keys", "fill");
+            for (int d = 0; d < height; ++d)
+            {
+                fprintf(out, "%5d %10lld %12lld %5.1f%% ", d, n_node[d], n_key[d],
+                        capacity[d] > 0 ? 100.0 * n_key[d] / capacity[d] : 0);
+                for (int i = 0; i < N_BUCKET; ++i)
+                    fprintf(out, " %lld", fill[d][i]);
+                fprintf(out, "\n");
+            }
+        }
+    };
+
+    // result of BTree::check()
+    //  errors break an invariant of BTree,
+    //  warnings are allowed by lazy merge and dead pages are left by merge
+    struct Check
+    {
+        static const int MAX_REPORT = 20; // errors printed to log
+
+        int height;
+        long long n_page, n_dead_page;
+        long long n_internal, n_leaf, n_key;
+        // errors
+        long long bad_page;    // out of file, unreadable or of unknown type
+        long long shared_page; // referenced twice
+        long long bad_order;   // key out of its node or of its parent's range
+        long long overflow;
+        long long bad_chain;  // prev_offset, succ_offset, seq_head and seq_tail
+        long long bad_height; // leaves of different depth
+        // warnings
+        long long underflow, n_empty_leaf;
+
+        Check() { memset(this, 0, sizeof(Check)); }
+
+        long long error() const
+        {
+            return bad_page + shared_page + bad_order +
+                   overflow + bad_chain + bad_height;
+        }
+
+        void print(FILE *out = stdout) const
+        {
+            fprintf(out, "height: %d, pages: %lld (dead: %lld)\n",
+                    height, n_page, n_dead_page);
+            fprintf(out, "nodes: %lld internal, %lld leaf, keys: %lld\n",
+                    n_internal, n_leaf, n_key);
+            fprintf(out, "errors: %lld (bad page %lld, shared page %lld, order %lld, "
+                         "overflow %lld, chain %lld, height %lld)\n",
+                    error(), bad_page, shared_page, bad_order,
+                    overflow, bad_chain, bad_height);
+            fprintf(out, "warnings: underflow %lld, empty leaf %lld\n",
+                    underflow, n_empty_leaf);
+        }
+    };
+
+    // fixed-memory cache of key -> at(key), see BTree::setCache()
+    //  1. set-associative: a key may only live in the WAYS entries of its set,
+    //     which are replaced in CLOCK order
+    //  2. TinyLFU admission: a count-min sketch of recent lookups,
+    //     a missed key replaces the CLOCK victim only if it is more frequent,
+    //     so that a scan of cold keys cannot flush the hot ones
+    // NOTE: keys are hashed by hashKey(), so a struct Key needs hash(h)
     template <class Key, class Value>
+    class HotCache
+    {
+    private:
+        static const int WAYS = 8;
+        static const int DEPTH = 4;        // rows of sketch
+        static const int MAX_COUNT = 15;   // of a sketch counter
+        static const int SAMPLE_RATIO = 8; // counters are halved every n_entry * SAMPLE_RATIO lookups
+
+        struct Set
+        {
+            Key key[WAYS];
+            Value value[WAYS];
+            unsigned char n, hand;
+            unsigned char ref; // bit i: entry i is referenced since the hand passed
+        };
+
+        Set *sets;
+        int set_mask;
+        unsigned char *sketch; // DEPTH rows of (sketch_mask + 1) counters
+        int sketch_mask;
+        long long n_sample, sample_size;
+
+        static unsigned long long hash(const Key &key)
+        {
+            return hash(key, std::integral_constant<bool, IsHashable<Key>::value>());
+        }
+        static unsigned long long hash(const Key &key, std::true_type) { return hashKey(key); }
+        // never called, as setCache() refuses such a Key
+        static unsigned long long hash(const Key &, std::false_type) { return 0; }
+
+        Set &setOf(unsigned long long h) { return sets[h & set_mask]; }
+
+        // counter of row d, double hashing by the high half of h
+        unsigned char &counter(unsigned long long h, int d)
+        {
+            unsigned long long step = (h >> 32) | 1;
+            return sketch[d * (sketch_mask + 1) + ((h + d * step) >> 8 & sketch_mask)];
+        }
+
+        int frequency(unsigned long long h)
+        {
+            int result = MAX_COUNT;
+            for (int d = 0; d < DEPTH; ++d)
+                result = std::min(result, (int)counter(h, d));
+            return result;
+        }
+
+        void record(unsigned long long h)
+        {
+            for (int d = 0; d < DEPTH; ++d)
+                if (counter(h, d) < MAX_COUNT)
+                    counter(h, d)++;
+            if (++n_sample == sample_size)
+            {
+                // aging
+                for (int i = 0; i < DEPTH * (sketch_mask + 1); ++i)
+                    sketch[i] >>= 1;
+                n_sample = 0;
+            }
+        }
+
+        //  returns: index of key in x, -1 if not found
+        static int find(const Set &x, const Key &key)
+        {
+            for (int i = 0; i < x.n; ++i)
+                if (x.key[i] == key)
+                    return i;
+            return -1;
+        }
+
+    public:
+        // n_entry is rounded down to a power of 2, at least WAYS
+        HotCache(int n_entry)
+        {
+            int n_set = 1;
+            while (n_set * 2 * WAYS <= n_entry)
+                n_set <<= 1;
+            sets = new Set[n_set];
+            set_mask = n_set - 1;
+            sketch_mask = n_set * WAYS - 1;
+            sketch = new unsigned char[DEPTH * (sketch_mask + 1)];
+            sample_size = (long long)n_set * WAYS * SAMPLE_RATIO;
+            clear();
+        }
+        HotCache(const HotCache &other) = delete;
+        HotCache &operator=(const HotCache &other) = delete;
+
+        ~HotCache()
+        {
+            delete[] sets;
+            delete[] sketch;
+        }
+
+        void clear()
+        {
+            for (int i = 0; i <= set_mask; ++i)
+                sets[i].n = sets[i].hand = sets[i].ref = 0;
+            memset(sketch, 0, DEPTH * (sketch_mask + 1));
+            n_sample = 0;
+        }
+
+        // a lookup, counted by the sketch whether it hits or not
+        bool get(const Key &key, Value &value)
+        {
+            unsigned long long h = hash(key);
+            record(h);
+            Set &x = setOf(h);
+            int i = find(x, key);
+            if (i == -1)
+                return false;
+            value = x.value[i];
+            x.ref |= 1 << i;
+            return true;
+        }
+
+        // offer (key, value) after a missed get()
+        void admit(const Key &key, const Value &value)
+        {
+            unsigned long long h = hash(key);
+            Set &x = setOf(h);
+            if (x.n < WAYS)
+            {
+                x.key[x.n] = key, x.value[x.n] = value;
+                x.n++;
+                return;
+            }
+            // CLOCK: the first entry not referenced since the hand passed
+            while (x.ref >> x.hand & 1)
+            {
+                x.ref &= ~(1 << x.hand);
+                x.hand = (x.hand + 1) % WAYS;
+            }
+            int victim = x.hand;
+            if (frequency(h) <= frequency(hash(x.key[victim])))
+                return;
+            x.key[victim] = key, x.value[victim] = value;
+            x.hand = (x.hand + 1) % WAYS;
+        }
+
+        // write through, if key is cached
+        void update(const Key &key, const Value &value)
+        {
+            Set &x = setOf(hash(key));
+            int i = find(x, key);
+            if (i != -1)
+                x.value[i] = value;
+        }
+    };
+
+    // Search: in-node search policy, see LinearSearch
+    // Layout: leaf layout, see PlainLeaf
+    template <class Key, class Value, class Search = LinearSearch,
+              class Layout = PlainLeaf>
     class BTree
     {
     private:
         static const int BLOCK_SIZE = 1 << 12;
 
-        FILE *file;
+        // pages are accessed by pread/pwrite
+        struct PageFile
+        {
+            int fd;
+            Stats stats;
+        };
+        PageFile file;
         char file_path[200];
+        OpenMode open_mode;
+        // NOTE: lazy merge
+        //  erase() never rotates or merges, leaves may become empty
+        //  and key[k] may be greater than the max key of child[k]
+        //  compact() rebuilds the tree in a batched pass
+        bool is_lazy_merge;
+        // consulted by at() if not nullptr, see setCache()
+        HotCache<Key, Value> *cache;
 
         enum NodeType
         {
@@ -27,78 +847,157 @@ namespace sjtu
             static const int DATA_SIZE = 4000;
             static constexpr int MAX_M =
                 DATA_SIZE / (sizeof(Key) + sizeof(int)) - 1;
-            static const int MAX_L =
-                DATA_SIZE / (sizeof(Key) + sizeof(Value)) - 1;
+            static const bool IS_PACKED = Layout::IS_PACKED;
+            // n_key of a leaf which always fits in its page
+            static const int FIT_L =
+                (DATA_SIZE - Layout::HEADER_SIZE) / (sizeof(Key) + sizeof(Value));
+            static const int MAX_L = IS_PACKED ? 2 * FIT_L - 1 : FIT_L - 1;
+            static const int MIN_L = FIT_L >> 1;
+            // NOTE: with fewer records per page MIN_L / MAX_L degenerate and split / merge break,
+            //  e.g. a MultiBTree with a large POSTING_SIZE or Value
+            static_assert(FIT_L >= 4, "a leaf page should hold at least 4 records of Key and Value");
+            static_assert(MAX_M >= 4, "an internal page should hold at least 4 children");
             // NOTE:
             //  MAX_M: max n_child in internal node
             //      (MAX_M - 1) / 2 <= n_key < MAX_M
             //  MAX_L: max n_key in leaf node
-            //      (MAX_L + 1) / 2 <= n_key <= MAX_L
+            //      MIN_L <= n_key <= MAX_L
+            //      a packed leaf also overflows when its page is full,
+            //      while a half (split) or a merge of underflows always fits
+            static const int STORAGE_SIZE =
+                (MAX_L + 1) * (sizeof(Key) + sizeof(Value)) > DATA_SIZE
+                    ? (MAX_L + 1) * (sizeof(Key) + sizeof(Value))
+                    : DATA_SIZE;
 
             int byte_offset;
             // >>>>> store in disk
             int prev_offset, succ_offset; // for sequential read
             NodeType node_type;
             int n_key;
+            PageModel model; // see Search::fit()
             // NOTE: for Internal node
             //  1. n_child = n_key + 1
             //  2. child[k] <= key[k] < child[k + 1]
             //     "==" holds for some keys in child[k]
-            char storage[DATA_SIZE];
+            char storage[STORAGE_SIZE];
             // <<<<< store in disk
+            // NOTE: a packed leaf is stored in page instead of storage,
+            //  and decoded to storage at the first key() / value()
+            char page[IS_PACKED ? DATA_SIZE : 1];
+            bool is_decoded;
+            int n_packed; // n_key of page
+
+            void decode()
+            {
+                if (IS_PACKED && !is_decoded)
+                {
+                    Layout::decode(page, n_packed, (Key *)storage,
+                                   (Value *)(storage + (MAX_L + 1) * sizeof(Key)));
+                    is_decoded = true;
+                }
+            }
 
         public:
-            Node() { node_type = NodeType::None; }
+            Node() : is_decoded(true) { node_type = NodeType::None; }
 
-            Node(NodeType node_type, int offset)
+            Node(NodeType node_type, int offset) : is_decoded(true)
             {
                 byte_offset = offset;
                 prev_offset = succ_offset = -1;
                 this->node_type = node_type;
                 n_key = 0;
+                model = PageModel();
             }
 
-            Node(FILE *file, int offset) { load(file, offset); }
+            Node(PageFile &file, int offset) : is_decoded(true) { load(file, offset); }
+
+            // whether a page read from disk can be accessed safely
+            bool isValid()
+            {
+                if (node_type == NodeType::Internal)
+                    return n_key >= 0 && n_key < MAX_M;
+                if (node_type == NodeType::Leaf)
+                    return n_key >= 0 && n_key <= MAX_L &&
+                           (!IS_PACKED || Layout::isValid(page, n_key, DATA_SIZE));
+                return false;
+            }
 
             bool isOverflow()
             {
+                if (node_type == NodeType::Leaf && IS_PACKED && n_key > FIT_L)
+                {
+                    decode();
+                    if (Layout::size((Key *)storage, &value(0), n_key) > DATA_SIZE)
+                        return true;
+                }
                 return (node_type == NodeType::Leaf && n_key > MAX_L) ||
                        (node_type == NodeType::Internal && n_key >= MAX_M);
             }
 
             bool isUnderflow()
             {
-                return (node_type == NodeType::Leaf && n_key < (MAX_L + 1) >> 1) ||
+                return (node_type == NodeType::Leaf && n_key < MIN_L) ||
                        (node_type == NodeType::Internal && n_key < (MAX_M - 1) >> 1);
             }
 
+            static const int DISK_SIZE =
+                3 * sizeof(int) + sizeof(NodeType) + sizeof(PageModel) + DATA_SIZE;
+
+            // members in disk, accessed by a single syscall
+            void diskLayout(iovec *iov)
+            {
+                iov[0].iov_base = &prev_offset, iov[0].iov_len = sizeof(int);
+                iov[1].iov_base = &succ_offset, iov[1].iov_len = sizeof(int);
+                iov[2].iov_base = &node_type, iov[2].iov_len = sizeof(NodeType);
+                iov[3].iov_base = &n_key, iov[3].iov_len = sizeof(int);
+                iov[4].iov_base = &model, iov[4].iov_len = sizeof(PageModel);
+                iov[5].iov_base = IS_PACKED ? page : storage, iov[5].iov_len = DATA_SIZE;
+            }
+
             // load from file
-            void load(FILE *file, int offset)
+            void load(PageFile &file, int offset)
             {
                 byte_offset = offset;
-                fseek(file, offset, SEEK_SET);
-
-                fread(&prev_offset, sizeof(int), 1, file);
-                fread(&succ_offset, sizeof(int), 1, file);
-                fread(&node_type, sizeof(NodeType), 1, file);
-                fread(&n_key, sizeof(int), 1, file);
-                fread(&storage, sizeof(char), DATA_SIZE, file);
+                iovec iov[6];
+                diskLayout(iov);
+                if (preadv(file.fd, iov, 6, offset) != DISK_SIZE)
+                    throw runtime_error();
+                file.stats.page_read++;
+                file.stats.byte_read += DISK_SIZE;
+                if (IS_PACKED)
+                {
+                    is_decoded = node_type != NodeType::Leaf;
+                    n_packed = n_key;
+                    if (is_decoded)
+                        memcpy(storage, page, DATA_SIZE);
+                }
             }
 
             // save to file
-            void save(FILE *file)
+            void save(PageFile &file)
             {
-                fseek(file, byte_offset, SEEK_SET);
-
-                fwrite(&prev_offset, sizeof(int), 1, file);
-                fwrite(&succ_offset, sizeof(int), 1, file);
-                fwrite(&node_type, sizeof(NodeType), 1, file);
-                fwrite(&n_key, sizeof(int), 1, file);
-                fwrite(&storage, sizeof(char), DATA_SIZE, file);
+                if (IS_PACKED && node_type != NodeType::Leaf)
+                    memcpy(page, storage, DATA_SIZE);
+                else if (IS_PACKED && (is_decoded || n_key != n_packed))
+                {
+                    decode();
+                    if (!Layout::encode((Key *)storage, &value(0), n_key, page, DATA_SIZE))
+                        throw runtime_error();
+                    n_packed = n_key;
+                }
+                if (!IS_PACKED || is_decoded)
+                    Search::fit((Key *)storage, n_key, model);
+                iovec iov[6];
+                diskLayout(iov);
+                if (pwritev(file.fd, iov, 6, byte_offset) != DISK_SIZE)
+                    throw runtime_error();
+                file.stats.page_write++;
+                file.stats.byte_write += DISK_SIZE;
             }
 
             Key &key(int k)
             {
+                decode();
                 return *(Key *)(storage + k * sizeof(Key));
             }
             int &child(int k)
@@ -113,19 +1012,35 @@ namespace sjtu
             {
                 if (node_type != NodeType::Leaf)
                     throw runtime_error();
+                decode();
                 return *(Value *)(storage +
                                   (MAX_L + 1) * sizeof(Key) +
                                   k * sizeof(Value));
             }
 
+            // read key[k] / value[k] without decoding a packed leaf
+            Key keyAt(int k)
+            {
+                return !IS_PACKED || is_decoded ? key(k)
+                                                : Layout::template key<Key>(page, k);
+            }
+            Value valueAt(int k)
+            {
+                return !IS_PACKED || is_decoded
+                           ? value(k)
+                           : Layout::template value<Key, Value>(page, n_packed, k);
+            }
+
             // returns: k
             //  key[k - 1] < target_key <= key[k]
-            int find(const Key &target_key)
+            // NOTE: target_key may be any type comparable with Key
+            //  (e.g. a bare key probing composite keys of MultiBTree)
+            template <class K>
+            int find(const K &target_key)
             {
-                int k = 0;
-                while (k < n_key && target_key > key(k))
-                    k++;
-                return k;
+                if (IS_PACKED && !is_decoded)
+                    return Layout::template find<Key>(page, n_key, target_key);
+                return Search::find((Key *)storage, n_key, target_key, model);
             }
 
             // insert key to key[k] and child to child[k + b]
@@ -164,9 +1079,10 @@ namespace sjtu
                 for (int i = k; i < n_key; ++i)
                 {
                     key(i) = key(i + 1);
-                    node_type == NodeType::Leaf
-                        ? value(i) = value(i + 1)
-                        : child(i) = child(i + 1);
+                    if (node_type == NodeType::Leaf)
+                        value(i) = value(i + 1);
+                    else
+                        child(i) = child(i + 1);
                 }
                 n_key--;
             }
@@ -176,24 +1092,98 @@ namespace sjtu
         int current_offset;
         int root_offset;
         int seq_head, seq_tail;
+        int generation; // increased by every writer, see refresh()
         // <<<<< store in disk
 
+        // NOTE: a tree of MAX_HEIGHT levels holds
+        //  at least ((MAX_M - 1) / 2)^(MAX_HEIGHT - 2) keys
+        static const int MAX_HEIGHT = Analysis::MAX_LEVEL;
+        // pages pinned by the last descend(), path[0] is root
+        //  slot[d]: key[slot[d] - 1] < key <= key[slot[d]] in path[d]
+        Node path[MAX_HEIGHT];
+        int slot[MAX_HEIGHT];
+        // depth of leaves, -1 if unknown
+        //  kept by every walk from root, so that estimate_range() stops above leaves
+        int leaf_depth;
+
     private:
         // lower_bound
+        //  x: the leaf found
         // returns: <is_found, <byte_offset, k>>
+        template <class K>
         pair<bool, pair<int, int>> find(
-            int root_offset, const Key &key)
+            int root_offset, const K &key, Node &x)
         {
-            Node x(file, root_offset);
+            file.stats.query++;
+            x.load(file, root_offset);
+            int d = 0;
             while (x.node_type != NodeType::Leaf)
             {
                 int k = x.find(key);
                 x.load(file, x.child(k));
+                d++;
             }
+            leaf_depth = d;
             int k = x.find(key);
-            // if k == x.n_key, this must be end()
+            // NOTE: key[k] may be out of date (lazy merge)
+            //  skip to the next key, if k == x.n_key, this must be end()
+            while (k == x.n_key && x.succ_offset != -1)
+                k = 0, x.load(file, x.succ_offset);
             return pair<bool, pair<int, int>>(
-                k != x.n_key && x.key(k) == key, pair<int, int>(x.byte_offset, k));
+                k != x.n_key && x.keyAt(k) == key, pair<int, int>(x.byte_offset, k));
+        }
+
+        template <class K>
+        pair<bool, pair<int, int>> find(
+            int root_offset, const K &key)
+        {
+            Node x;
+            return find(root_offset, key, x);
+        }
+
+        // pin every page from root to leaf
+        //  returns: depth of leaf
+        int descend(const Key &key)
+        {
+            int d = 0;
+            path[0].load(file, root_offset);
+            while (path[d].node_type != NodeType::Leaf)
+            {
+                if (d + 1 == MAX_HEIGHT)
+                    throw runtime_error();
+                slot[d] = path[d].find(key);
+                path[d + 1].load(file, path[d].child(slot[d]));
+                d++;
+            }
+            slot[d] = path[d].find(key);
+            leaf_depth = d;
+            return d;
+        }
+
+        // at() through cache, timed into stats
+        Value cachedAt(const Key &key)
+        {
+            auto start = std::chrono::steady_clock::now();
+            Value value;
+            bool is_hit = cache->get(key, value);
+            if (is_hit)
+                file.stats.query++;
+            else
+            {
+                Node x;
+                pair<bool, pair<int, int>>
+                    result = find(root_offset, key, x);
+                value = result.first ? x.valueAt(result.second.second) : Value();
+                cache->admit(key, value);
+            }
+            long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+            if (is_hit)
+                file.stats.cache_hit++, file.stats.hit_ns += ns;
+            else
+                file.stats.cache_miss++, file.stats.miss_ns += ns;
+            return value;
         }
 
         // >>>>> insert
@@ -203,6 +1193,7 @@ namespace sjtu
         //  may change seq_tail
         pair<Key, int> split(Node &x)
         {
+            file.stats.split++;
             Node succ(x.node_type,
                       current_offset += BLOCK_SIZE);
 
@@ -221,8 +1212,10 @@ namespace sjtu
                 if (succ.succ_offset == -1)
                     seq_tail = succ.byte_offset;
 
-                x.n_key = (Node::MAX_L + 1) >> 1;
-                succ.n_key = Node::MAX_L + 1 - x.n_key;
+                // NOTE: a packed leaf may overflow with less than MAX_L + 1 keys
+                int n_key = x.n_key;
+                x.n_key = n_key >> 1;
+                succ.n_key = n_key - x.n_key;
                 for (int i = 0; i < succ.n_key; ++i)
                 {
                     succ.key(i) = x.key(x.n_key + i);
@@ -248,50 +1241,40 @@ namespace sjtu
             }
         }
 
-        // find() + solveOverflow() requires 2x read + 1x write
-        //  However, recursive insert() only need 1x read + 1x write
-        // returns: <key_not_found, <new_key, succ_offset>>
-        pair<bool, pair<Key, int>> insert(
-            int offset, const Key &key, const Value &value)
+        // split path[d], a leaf which overflows, then its ancestors bottom-up,
+        //  growing taller at the root
+        //  path and slot are filled by descend()
+        void splitPath(int d)
         {
-            // NOTE: root is NOT handled.
-            Node x(file, offset);
-
-            if (x.node_type == NodeType::Leaf)
+            pair<Key, int> result = split(path[d]);
+            Key new_key = result.first;
+            int succ_offset = result.second;
+            while (--d >= 0)
             {
-                int k = x.find(key);
-                if (k != x.n_key && x.key(k) == key)
-                    return pair<bool, pair<Key, int>>(
-                        false, pair<Key, int>(key, -1));
-
-                x.insertData(k, key, value);
+                Node &x = path[d];
+                x.insertChild(slot[d], 1, new_key, succ_offset);
                 if (!x.isOverflow())
                 {
                     x.save(file);
-                    return pair<bool, pair<Key, int>>(
-                        true, pair<Key, int>(key, -1));
+                    return;
                 }
-                return pair<bool, pair<Key, int>>(true, split(x));
+                pair<Key, int> upper = split(x);
+                new_key = upper.first;
+                succ_offset = upper.second;
             }
 
-            int k = x.find(key);
-            pair<bool, pair<int, Key>>
-                result = insert(x.child(k), key, value);
-            if (!result.first ||
-                result.second.second == -1)
-                return result;
-
-            x.insertChild(
-                k, 1, result.second.first,
-                result.second.second);
-            if (!x.isOverflow())
-            {
-                x.save(file);
-                return pair<bool, pair<Key, int>>(
-                    true, pair<Key, int>(key, -1));
-            }
-            return pair<bool, pair<Key, int>>(true, split(x));
+            // grow taller
+            Node x(NodeType::Internal,
+                   current_offset += BLOCK_SIZE);
+            x.n_key = 1;
+            x.key(0) = new_key;
+            x.child(0) = root_offset;
+            x.child(1) = succ_offset;
+            root_offset = x.byte_offset;
+            leaf_depth++;
+            x.save(file);
         }
+
         // <<<<< insert
 
         // >>>>> remove
@@ -318,6 +1301,7 @@ namespace sjtu
                     }
                     left.save(file);
                     child.save(file);
+                    file.stats.rotate++;
                     return true;
                 }
 
@@ -345,6 +1329,7 @@ namespace sjtu
                     }
                     right.save(file);
                     child.save(file);
+                    file.stats.rotate++;
                     return true;
                 }
 
@@ -358,6 +1343,7 @@ namespace sjtu
         void merge(Node &x, int k,
                    Node &child, Node &left, Node &right)
         {
+            file.stats.merge++;
             if (left.node_type != NodeType::None)
             {
                 // merge to left
@@ -429,66 +1415,250 @@ namespace sjtu
             }
         }
 
-        // returns: <key_found, <child_node, max_key>>
-        //  1. update
-        //      if max key is removed, key[k] may change
-        //      NOTE: max_key is not accurate if (key[k] != key)
-        //  2. rotate
-        //  3. merge
-        pair<bool, pair<Node, Key>> remove(int offset, const Key &key)
+        // <<<<< remove
+
+        // walk the subtree of offset, which is at level d
+        void analyze(int offset, int d, Analysis &result)
         {
-            // NOTE: root is NOT handled.
             Node x(file, offset);
-
+            if (d + 1 > result.height)
+                result.height = d + 1;
+            int max_n_key = x.node_type == NodeType::Leaf
+                                ? Node::MAX_L
+                                : Node::MAX_M - 1;
+            int bucket = x.n_key * Analysis::N_BUCKET / max_n_key;
+            result.n_node[d]++;
+            result.n_key[d] += x.n_key;
+            result.capacity[d] += max_n_key;
+            result.fill[d][bucket < Analysis::N_BUCKET ? bucket : Analysis::N_BUCKET - 1]++;
             if (x.node_type == NodeType::Leaf)
             {
-                int k = x.find(key);
-                if (k == x.n_key || x.key(k) != key)
-                    return pair<bool, pair<Node, Key>>(
-                        false, pair<Node, Key>(x, key));
-
-                x.remove(k);
-                return pair<bool, pair<Node, Key>>(
-                    true, pair<Node, Key>(x, x.key(x.n_key - 1)));
+                result.n_empty_leaf += x.n_key == 0;
+                return;
             }
+            for (int i = 0; i <= x.n_key; ++i)
+                analyze(x.child(i), d + 1, result);
+        }
 
-            int k = x.find(key);
-            pair<bool, pair<Node, Key>>
-                result = remove(x.child(k), key);
-            if (!result.first)
-                return result;
+        // >>>>> check
+        // NOTE: one node per level and a bitmap of pages are kept in memory
+        struct CheckState
+        {
+            Check result;
+            FILE *log;
+            unsigned char *visited; // bitmap of pages
+            int leaf_depth;         // -1 before the first leaf
+            int last_leaf, last_succ;
+            bool has_last_key;
+            Key last_key; // of the previous leaf
+        };
 
-            Node child = result.second.first;
-            Key max_key = result.second.second;
-            // >>>>> update
-            //  key[k] may be removed
-            if (k < x.n_key && x.key(k) == key)
-                x.key(k) = max_key;
+        void report(CheckState &s, long long &counter, int offset, const char *what)
+        {
+            counter++;
+            if (s.log != nullptr && s.result.error() <= Check::MAX_REPORT)
+                fprintf(s.log, "page %d: %s\n", offset, what);
+        }
 
-            // normal case
-            if (!child.isUnderflow())
+        // returns: whether offset is a page in file, which is not visited
+        //  the page is marked as visited
+        bool visit(CheckState &s, int offset)
+        {
+            if (offset <= 0 || offset > current_offset || offset % BLOCK_SIZE != 0)
+            {
+                report(s, s.result.bad_page, offset, "out of file");
+                return false;
+            }
+            int page = offset / BLOCK_SIZE;
+            if (s.visited[page >> 3] >> (page & 7) & 1)
             {
-                child.save(file);
-                return pair<bool, pair<Node, Key>>(
-                    true, pair<Node, Key>(x, max_key));
+                report(s, s.result.shared_page, offset, "referenced twice");
+                return false;
             }
+            s.visited[page >> 3] |= 1 << (page & 7);
+            return true;
+        }
 
-            // underflow
-            Node left, right;
-            if (k - 1 >= 0)
-                left.load(file, x.child(k - 1));
-            if (k + 1 <= x.n_key)
-                right.load(file, x.child(k + 1));
-            // >>>>> rotate / merge
-            if (!rotate(x, k, child, left, right))
-                merge(x, k, child, left, right);
+        // returns: whether x is loaded and can be accessed safely
+        bool load(CheckState &s, Node &x, int offset)
+        {
+            try
+            {
+                x.load(file, offset);
+            }
+            catch (runtime_error &)
+            {
+                report(s, s.result.bad_page, offset, "unreadable");
+                return false;
+            }
+            if (!x.isValid())
+            {
+                bool is_overflow =
+                    (x.node_type == NodeType::Leaf && x.n_key > Node::MAX_L) ||
+                    (x.node_type == NodeType::Internal && x.n_key >= Node::MAX_M);
+                if (is_overflow)
+                    report(s, s.result.overflow, offset, "n_key out of page");
+                else
+                    report(s, s.result.bad_page, offset, "bad node type or n_key");
+                return false;
+            }
+            return true;
+        }
+
+        // walk the subtree of offset, which is at level d
+        //  every key is in (*lo, *hi], nullptr means no bound
+        void check(CheckState &s, int offset, int d, const Key *lo, const Key *hi)
+        {
+            Node x;
+            if (!visit(s, offset) || !load(s, x, offset))
+                return;
+            if (d + 1 > s.result.height)
+                s.result.height = d + 1;
+            if (x.isOverflow())
+                report(s, s.result.overflow, offset, "overflow");
+            else if (d > 0 && x.isUnderflow())
+                s.result.underflow++;
+            for (int i = 1; i < x.n_key; ++i)
+                if (!(x.key(i) > x.key(i - 1)))
+                {
+                    report(s, s.result.bad_order, offset, "keys not increasing");
+                    break;
+                }
+
+            if (x.node_type == NodeType::Internal)
+            {
+                s.result.n_internal++;
+                if (d + 1 == MAX_HEIGHT)
+                {
+                    report(s, s.result.bad_height, offset, "too deep");
+                    return;
+                }
+                for (int i = 0; i <= x.n_key; ++i)
+                    check(s, x.child(i), d + 1,
+                          i == 0 ? lo : &x.key(i - 1),
+                          i == x.n_key ? hi : &x.key(i));
+                return;
+            }
 
-            return pair<bool, pair<Node, Key>>(
-                true, pair<Node, Key>(x, max_key));
+            s.result.n_leaf++;
+            s.result.n_key += x.n_key;
+            s.result.n_empty_leaf += x.n_key == 0;
+            if (s.leaf_depth == -1)
+                s.leaf_depth = d;
+            else if (s.leaf_depth != d)
+                report(s, s.result.bad_height, offset, "leaf of different depth");
+            // child[k] <= key[k] < child[k + 1]
+            for (int i = 0; i < x.n_key; ++i)
+                if ((lo != nullptr && !(x.key(i) > *lo)) ||
+                    (hi != nullptr && x.key(i) > *hi) ||
+                    (s.has_last_key && !(x.key(i) > s.last_key)))
+                {
+                    report(s, s.result.bad_order, offset, "key out of range");
+                    break;
+                }
+            if (x.n_key > 0)
+                s.has_last_key = true, s.last_key = x.key(x.n_key - 1);
+            // leaves in key order form the sequence
+            if (s.last_leaf == -1
+                    ? offset != seq_head || x.prev_offset != -1
+                    : offset != s.last_succ || x.prev_offset != s.last_leaf)
+                report(s, s.result.bad_chain, offset, "prev_offset or seq_head");
+            s.last_leaf = offset, s.last_succ = x.succ_offset;
         }
-        // <<<<< remove
+        // <<<<< check
 
     public:
+        const Stats &stats() const { return file.stats; }
+
+        void resetStats() { file.stats = Stats(); }
+
+        // walk the whole tree, reading every reachable page once
+        Analysis analyze()
+        {
+            Analysis result;
+            analyze(root_offset, 0, result);
+            result.n_page = current_offset / BLOCK_SIZE;
+            for (int d = 0; d < result.height; ++d)
+                result.n_dead_page -= result.n_node[d];
+            result.n_dead_page += result.n_page;
+            return result;
+        }
+
+        // verify the whole tree, reading every reachable page once
+        //  errors are printed to log, at most Check::MAX_REPORT of them
+        // NOTE: memory is bounded by the height and
+        //  a bitmap of current_offset / BLOCK_SIZE bits
+        Check check(FILE *log = nullptr)
+        {
+            CheckState s;
+            s.log = log;
+            s.leaf_depth = s.last_leaf = s.last_succ = -1;
+            s.has_last_key = false;
+            int n_page = current_offset > 0 ? current_offset / BLOCK_SIZE : 0;
+            s.visited = new unsigned char[(n_page >> 3) + 1]();
+            check(s, root_offset, 0, nullptr, nullptr);
+            if (s.last_leaf != -1 && (s.last_leaf != seq_tail || s.last_succ != -1))
+                report(s, s.result.bad_chain, s.last_leaf, "succ_offset or seq_tail");
+            s.result.n_page = n_page;
+            for (int page = 1; page <= n_page; ++page)
+                if (!(s.visited[page >> 3] >> (page & 7) & 1))
+                    s.result.n_dead_page++;
+            delete[] s.visited;
+            return s.result;
+        }
+
+        // build a clean tree in new_path from the leaf chain,
+        //  which works on a damaged tree as long as its leaves are readable
+        //  1. follow succ_offset from seq_head, until a bad page or a cycle
+        //  2. follow prev_offset from seq_tail back to the break,
+        //     then append those leaves in order
+        //  a key not less than the next key of its leaf, or not greater than
+        //  the last appended key, is dropped
+        //  returns: number of keys in the new tree
+        long long rebuild(const char *new_path, int fill_percent = 100)
+        {
+            CheckState s;
+            s.log = nullptr;
+            s.has_last_key = false;
+            int n_page = current_offset > 0 ? current_offset / BLOCK_SIZE : 0;
+            s.visited = new unsigned char[(n_page >> 3) + 1]();
+            int *tail = new int[n_page + 1]; // leaves after the break, in reverse
+            int n_tail = 0;
+            long long n_key = 0;
+            BTree other(new_path);
+            bulk_loader loader(&other, fill_percent);
+            auto salvage = [&](Node &x) {
+                for (int i = 0; i < x.n_key; ++i)
+                    if ((i + 1 == x.n_key || x.key(i + 1) > x.key(i)) &&
+                        (!s.has_last_key || x.key(i) > s.last_key))
+                    {
+                        loader.append(x.key(i), x.value(i));
+                        s.has_last_key = true, s.last_key = x.key(i), n_key++;
+                    }
+            };
+            Node x;
+            for (int offset = seq_head;
+                 offset != -1 && visit(s, offset) &&
+                 load(s, x, offset) && x.node_type == NodeType::Leaf;
+                 offset = x.succ_offset)
+                salvage(x);
+            for (int offset = seq_tail;
+                 offset != -1 && visit(s, offset) &&
+                 load(s, x, offset) && x.node_type == NodeType::Leaf;
+                 offset = x.prev_offset)
+                tail[n_tail++] = offset;
+            while (n_tail > 0)
+            {
+                x.load(file, tail[--n_tail]);
+                salvage(x);
+            }
+            loader.finish();
+            delete[] tail;
+            delete[] s.visited;
+            addStats(other);
+            return n_key;
+        }
+
         // DEBUG function
         void displayLeaf()
         {
@@ -528,121 +1698,304 @@ namespace sjtu
             displayAll(x.child(x.n_key), tab + 1);
         }
 
-    public:
-        BTree() : file_path("tree_data.bin")
+    private:
+        // >>>>> file
+        static const int HEADER_SIZE = 5;
+
+        void loadHeader()
         {
-            file = fopen(file_path, "rb+");
-            if (file != nullptr)
-            {
-                fseek(file, 0, SEEK_SET);
-                fread(&current_offset, sizeof(int), 1, file);
-                fread(&root_offset, sizeof(int), 1, file);
-                fread(&seq_head, sizeof(int), 1, file);
-                fread(&seq_tail, sizeof(int), 1, file);
-                return;
-            }
+            int header[HEADER_SIZE];
+            if (pread(file.fd, header, sizeof(header), 0) != sizeof(header))
+                throw runtime_error();
+            file.stats.page_read++;
+            file.stats.byte_read += sizeof(header);
+            current_offset = header[0], root_offset = header[1];
+            seq_head = header[2], seq_tail = header[3];
+            generation = header[4];
+            leaf_depth = -1;
+        }
 
-            file = fopen(file_path, "wb+");
+        // count the I/O of other, a temporary tree of compact() or rebuild(),
+        //  as I/O of this tree, including the header other writes when it is closed
+        void addStats(const BTree &other)
+        {
+            file.stats += other.file.stats;
+            file.stats.page_write++;
+            file.stats.byte_write += HEADER_SIZE * sizeof(int);
+        }
+
+        void saveHeader()
+        {
+            int header[HEADER_SIZE] = {
+                current_offset, root_offset,
+                seq_head, seq_tail, generation};
+            if (pwrite(file.fd, header, sizeof(header), 0) != sizeof(header))
+                throw runtime_error();
+            file.stats.page_write++;
+            file.stats.byte_write += sizeof(header);
+        }
+
+        // truncate to an empty tree
+        void reset()
+        {
+            if (ftruncate(file.fd, 0) != 0)
+                throw runtime_error();
             current_offset = root_offset = BLOCK_SIZE;
             seq_head = seq_tail = BLOCK_SIZE;
+            generation = 0;
+            leaf_depth = 0;
+            if (cache != nullptr)
+                cache->clear();
             Node(NodeType::Leaf, root_offset).save(file);
+            saveHeader();
         }
 
-        BTree(const char *fname)
+        void open()
         {
-            strcpy(file_path, fname);
-            file = fopen(file_path, "rb+");
-            if (file != nullptr)
-            {
-                fseek(file, 0, SEEK_SET);
-                fread(&current_offset, sizeof(int), 1, file);
-                fread(&root_offset, sizeof(int), 1, file);
-                fread(&seq_head, sizeof(int), 1, file);
-                fread(&seq_tail, sizeof(int), 1, file);
+            if (open_mode == OpenMode::ReadOnly)
+            {
+                file.fd = ::open(file_path, O_RDONLY);
+                if (file.fd == -1)
+                    throw runtime_error();
+                loadHeader();
                 return;
             }
 
-            file = fopen(file_path, "wb+");
-            current_offset = root_offset = BLOCK_SIZE;
-            seq_head = seq_tail = BLOCK_SIZE;
-            Node(NodeType::Leaf, root_offset).save(file);
+            file.fd = ::open(file_path, O_RDWR | O_CREAT, 0644);
+            if (file.fd == -1)
+                throw runtime_error();
+            struct stat file_stat;
+            if (fstat(file.fd, &file_stat) == 0 && file_stat.st_size > 0)
+                loadHeader();
+            else
+                reset();
+        }
+
+        void checkWritable()
+        {
+            if (open_mode == OpenMode::ReadOnly)
+                throw runtime_error();
+        }
+        // <<<<< file
+
+    public:
+        BTree()
+            : file_path("tree_data.bin"),
+              open_mode(OpenMode::ReadWrite), is_lazy_merge(false), cache(nullptr)
+        {
+            open();
+        }
+
+        BTree(const char *fname, OpenMode open_mode = OpenMode::ReadWrite)
+            : open_mode(open_mode), is_lazy_merge(false), cache(nullptr)
+        {
+            strcpy(file_path, fname);
+            open();
         }
 
         ~BTree()
         {
-            fseek(file, 0, SEEK_SET);
-            fwrite(&current_offset, sizeof(int), 1, file);
-            fwrite(&root_offset, sizeof(int), 1, file);
-            fwrite(&seq_head, sizeof(int), 1, file);
-            fwrite(&seq_tail, sizeof(int), 1, file);
+            if (open_mode == OpenMode::ReadWrite)
+            {
+                generation++;
+                saveHeader();
+            }
+            close(file.fd);
+            delete cache;
+        }
 
-            fclose(file);
+        // ReadOnly: switch to the latest version of file_path
+        //  1. a builder renamed a new file over file_path
+        //  2. a writer closed file_path (generation changes)
+        //  returns: whether a new version is loaded
+        bool refresh()
+        {
+            struct stat path_stat, file_stat;
+            bool is_replaced =
+                stat(file_path, &path_stat) == 0 &&
+                fstat(file.fd, &file_stat) == 0 &&
+                (path_stat.st_ino != file_stat.st_ino ||
+                 path_stat.st_dev != file_stat.st_dev);
+            if (is_replaced)
+            {
+                int new_file = ::open(file_path, O_RDONLY);
+                if (new_file != -1)
+                    close(file.fd), file.fd = new_file;
+            }
+            int old_generation = generation;
+            loadHeader();
+            bool is_changed = is_replaced || generation != old_generation;
+            if (is_changed && cache != nullptr)
+                cache->clear();
+            return is_changed;
         }
 
         // Clear the BTree
         void clear()
         {
-            fclose(file);
-            file = fopen(file_path, "wb+");
-            current_offset = root_offset = BLOCK_SIZE;
-            seq_head = seq_tail = BLOCK_SIZE;
-            Node(NodeType::Leaf, root_offset).save(file);
+            checkWritable();
+            reset();
         }
 
+        // descend once, then split bottom-up along the path
         bool insert(const Key &key, const Value &value)
         {
-            pair<bool, pair<Key, int>>
-                result = insert(root_offset, key, value);
-            if (result.second.second != -1)
-            {
-                // grow taller
-                Node x(NodeType::Internal,
-                       current_offset += BLOCK_SIZE);
-                x.n_key = 1;
-                x.key(0) = result.second.first;
-                x.child(0) = root_offset;
-                x.child(1) = result.second.second;
-                root_offset = x.byte_offset;
-                x.save(file);
+            checkWritable();
+            file.stats.insert++;
+            int d = descend(key);
+            Node &leaf = path[d];
+            int k = slot[d];
+            if (k != leaf.n_key && leaf.key(k) == key)
+                return false;
+
+            leaf.insertData(k, key, value);
+            if (cache != nullptr)
+                cache->update(key, value);
+            if (!leaf.isOverflow())
+            {
+                leaf.save(file);
+                return true;
             }
-            return result.first;
+            splitPath(d);
+            return true;
         }
 
+        // NOTE: a wider value may not fit a packed leaf of more than FIT_L records,
+        //  which is then split along the path as by insert
         bool modify(const Key &key, const Value &value)
         {
+            checkWritable();
+            Node x;
             pair<bool, pair<int, int>>
-                result = find(root_offset, key);
+                result = find(root_offset, key, x);
             if (!result.first)
                 return false;
-            iterator it(this, result.second);
-            it.modify(value);
+            x.value(result.second.second) = value;
+            if (!x.isOverflow())
+                x.save(file);
+            else
+            {
+                int d = descend(key);
+                path[d].value(slot[d]) = value;
+                splitPath(d);
+            }
+            if (cache != nullptr)
+                cache->update(key, value);
             return true;
         }
 
         Value at(const Key &key)
         {
+            if (cache != nullptr)
+                return cachedAt(key);
+            Node x;
             pair<bool, pair<int, int>>
-                result = find(root_offset, key);
+                result = find(root_offset, key, x);
             if (!result.first)
                 return Value();
-            iterator it(this, result.second);
-            return it.getValue();
+            return x.valueAt(result.second.second);
+        }
+
+        // values[i] = at(keys[i]), for i in [0, n)
+        //  keys are visited in increasing order,
+        //  so that keys in one leaf load the path only once
+        void at(const Key *keys, Value *values, int n)
+        {
+            int *order = new int[n];
+            for (int i = 0; i < n; ++i)
+                order[i] = i;
+            std::sort(order, order + n, [&](int a, int b) { return keys[b] > keys[a]; });
+
+            Node x;
+            bool is_loaded = false;
+            for (int i = 0; i < n; ++i)
+            {
+                const Key &key = keys[order[i]];
+                int k;
+                // the previous key is in x, and key <= max key of x
+                if (is_loaded && x.n_key > 0 && !(key > x.keyAt(x.n_key - 1)))
+                {
+                    file.stats.query++;
+                    k = x.find(key);
+                }
+                else
+                {
+                    k = find(root_offset, key, x).second.second;
+                    is_loaded = true;
+                }
+                values[order[i]] = k != x.n_key && x.keyAt(k) == key ? x.valueAt(k) : Value();
+            }
+            delete[] order;
         }
 
+        // descend once, then fix underflow bottom-up along the path
+        //  1. update
+        //      if max key is removed, key[k] may change
+        //  2. rotate
+        //  3. merge
+        //  stop as soon as a parent is clean and key is not its max key
         bool erase(const Key &key)
         {
-            pair<bool, pair<Node, Key>>
-                result = remove(root_offset, key);
-            if (result.first)
+            checkWritable();
+            file.stats.erase++;
+            int d = descend(key);
+            Node &leaf = path[d];
+            int k = slot[d];
+            if (k == leaf.n_key || leaf.key(k) != key)
+                return false;
+
+            leaf.remove(k);
+            if (cache != nullptr)
+                cache->update(key, Value());
+            if (is_lazy_merge)
+            {
+                leaf.save(file);
+                return true;
+            }
+            // NOTE: an empty leaf is merged, so max_key is not used
+            Key max_key = leaf.n_key > 0 ? leaf.key(leaf.n_key - 1) : key;
+            bool is_dirty = true;
+            Node left, right;
+            for (; d > 0; --d)
             {
-                Node root = result.second.first;
-                if (root.n_key > 0)
-                    root.save(file);
-                if (root.n_key == 0 &&
-                    root.node_type == NodeType::Internal)
-                    root_offset = root.child(0);
+                Node &x = path[d - 1], &child = path[d];
+                int k = slot[d - 1];
+                bool is_parent_dirty = false;
+                // >>>>> update
+                //  key[k] may be removed
+                if (k < x.n_key && x.key(k) == key)
+                    x.key(k) = max_key, is_parent_dirty = true;
+
+                if (!child.isUnderflow())
+                {
+                    if (is_dirty)
+                        child.save(file);
+                }
+                else
+                {
+                    // >>>>> rotate / merge
+                    left.node_type = right.node_type = NodeType::None;
+                    if (k - 1 >= 0)
+                        left.load(file, x.child(k - 1));
+                    if (k + 1 <= x.n_key)
+                        right.load(file, x.child(k + 1));
+                    if (!rotate(x, k, child, left, right))
+                        merge(x, k, child, left, right);
+                    is_parent_dirty = true;
+                }
+
+                if (!is_parent_dirty && k < x.n_key)
+                    return true;
+                is_dirty = is_parent_dirty;
             }
-            return result.first;
+
+            Node &root = path[0];
+            if (root.n_key == 0 &&
+                root.node_type == NodeType::Internal)
+                root_offset = root.child(0), leaf_depth--;
+            else if (is_dirty)
+                root.save(file);
+            return true;
         }
 
         class iterator
@@ -651,14 +2004,14 @@ namespace sjtu
 
         private:
             // Your private members go here
-            BTree<Key, Value> *tree_ptr;
+            BTree *tree_ptr;
             int offset, k;
 
         public:
             iterator() : tree_ptr(nullptr), offset(-1), k(-1) {}
-            iterator(BTree<Key, Value> *tree_ptr, int offset, int k)
+            iterator(BTree *tree_ptr, int offset, int k)
                 : tree_ptr(tree_ptr), offset(offset), k(k) {}
-            iterator(BTree<Key, Value> *tree_ptr, pair<int, int> loc)
+            iterator(BTree *tree_ptr, pair<int, int> loc)
                 : tree_ptr(tree_ptr), offset(loc.first), k(loc.second) {}
             iterator(const iterator &other)
             {
@@ -669,24 +2022,31 @@ namespace sjtu
 
             // modify by iterator
             // HACK: cause UB if iterator is invalid
+            // NOTE: if a wider value splits a packed leaf (see BTree::modify), iterators into it,
+            //  this one included, are invalid after
             bool modify(const Value &value)
             {
+                tree_ptr->checkWritable();
                 Node x(tree_ptr->file, offset);
                 x.value(k) = value;
-                x.save(file);
+                if (x.isOverflow())
+                    return tree_ptr->modify(x.key(k), value);
+                x.save(tree_ptr->file);
+                if (tree_ptr->cache != nullptr)
+                    tree_ptr->cache->update(x.key(k), value);
                 return true;
             }
 
             Key getKey() const
             {
                 Node x(tree_ptr->file, offset);
-                return x.key(k);
+                return x.keyAt(k);
             }
 
             Value getValue() const
             {
                 Node x(tree_ptr->file, offset);
-                return x.value(k);
+                return x.valueAt(k);
             }
 
             iterator operator++(int)
@@ -696,9 +2056,10 @@ namespace sjtu
 
                 iterator ret(*this);
                 Node x(tree_ptr->file, offset);
-                if (++k >= x.n_key &&
-                    x.succ_offset != -1)
-                    k = 0, offset = x.succ_offset;
+                // NOTE: skip empty leaves (lazy merge)
+                while (++k >= x.n_key &&
+                       x.succ_offset != -1)
+                    k = -1, offset = x.succ_offset, x.load(tree_ptr->file, offset);
                 return ret;
             }
 
@@ -708,9 +2069,10 @@ namespace sjtu
                     throw invalid_iterator();
 
                 Node x(tree_ptr->file, offset);
-                if (++k >= x.n_key &&
-                    x.succ_offset != -1)
-                    k = 0, offset = x.succ_offset;
+                // NOTE: skip empty leaves (lazy merge)
+                while (++k >= x.n_key &&
+                       x.succ_offset != -1)
+                    k = -1, offset = x.succ_offset, x.load(tree_ptr->file, offset);
                 return *this;
             }
 
@@ -720,11 +2082,14 @@ namespace sjtu
                     throw invalid_iterator();
 
                 iterator ret(*this);
-                Node x(tree_ptr->file, offset);
                 if (--k < 0)
                 {
-                    offset = x.prev_offset;
-                    Node prev(tree_ptr->file, offset);
+                    Node x(tree_ptr->file, offset);
+                    do
+                    {
+                        offset = x.prev_offset;
+                        x.load(tree_ptr->file, offset);
+                    } while (x.n_key == 0);
                     k = x.n_key - 1;
                 }
                 return ret;
@@ -735,11 +2100,14 @@ namespace sjtu
                 if (*this == tree_ptr->begin())
                     throw invalid_iterator();
 
-                Node x(tree_ptr->file, offset);
                 if (--k < 0)
                 {
-                    offset = x.prev_offset;
-                    Node prev(tree_ptr->file, offset);
+                    Node x(tree_ptr->file, offset);
+                    do
+                    {
+                        offset = x.prev_offset;
+                        x.load(tree_ptr->file, offset);
+                    } while (x.n_key == 0);
                     k = x.n_key - 1;
                 }
                 return *this;
@@ -761,7 +2129,11 @@ namespace sjtu
 
         iterator begin()
         {
-            return iterator(this, seq_head, 0);
+            // NOTE: skip empty leaves (lazy merge)
+            Node x(file, seq_head);
+            while (x.n_key == 0 && x.succ_offset != -1)
+                x.load(file, x.succ_offset);
+            return iterator(this, x.byte_offset, 0);
         }
 
         // return an iterator to the end(the next element after the last)
@@ -781,10 +2153,634 @@ namespace sjtu
         }
 
         // return an iterator whose key is the smallest key greater or equal than 'key'
-        iterator lower_bound(const Key &key)
+        template <class K>
+        iterator lower_bound(const K &key)
         {
             return iterator(this, find(root_offset, key).second);
         }
+
+        // forward-only cursor which keeps its leaf in memory,
+        //  so that a scan reads every leaf exactly once
+        class cursor
+        {
+            friend class BTree;
+
+        private:
+            BTree *tree_ptr;
+            Node x;
+            int k;
+
+            // skip to the next non-empty leaf
+            void settle()
+            {
+                while (k >= x.n_key && x.succ_offset != -1)
+                    k = 0, x.load(tree_ptr->file, x.succ_offset);
+            }
+
+        public:
+            cursor(BTree *tree_ptr, pair<int, int> loc)
+                : tree_ptr(tree_ptr), x(tree_ptr->file, loc.first), k(loc.second)
+            {
+                settle();
+            }
+
+            bool valid() const { return k < x.n_key; }
+
+            Key getKey() { return x.key(k); }
+
+            Value getValue() { return x.value(k); }
+
+            cursor &operator++()
+            {
+                if (!valid())
+                    throw invalid_iterator();
+                ++k, settle();
+                return *this;
+            }
+        };
+
+        // return a cursor at lower_bound(key)
+        template <class K>
+        cursor seek(const K &key)
+        {
+            return cursor(this, find(root_offset, key).second);
+        }
+
+        // return a cursor at begin()
+        cursor seekBegin()
+        {
+            return cursor(this, pair<int, int>(seq_head, 0));
+        }
+
+        // callback(key, value) for every key starting with prefix, in order
+        //  Key is constructible from prefix and has startsWith(), e.g. FixedString
+        //  a leaf is read only if every key after lower_bound(prefix) so far matched,
+        //  so the scan stops in the leaf of the first key without prefix
+        //  returns: number of keys found
+        template <class F>
+        long long prefix_scan(const char *prefix, F callback)
+        {
+            int len = strlen(prefix);
+            Node x;
+            int k = find(root_offset, Key(prefix), x).second.second;
+            long long n = 0;
+            while (true)
+            {
+                for (; k < x.n_key; ++k)
+                {
+                    Key key = x.keyAt(k);
+                    if (!key.startsWith(prefix, len))
+                        return n;
+                    callback(key, x.valueAt(k));
+                    n++;
+                }
+                if (x.succ_offset == -1)
+                    return n;
+                k = 0, x.load(file, x.succ_offset);
+            }
+        }
+
+        // approximate number of keys in [lo, hi], from separators of internal nodes
+        //  reads at most 2 pages per internal level and no leaf,
+        //  except when the root is a leaf or leaf_depth is unknown (once after open)
+        // NOTE:
+        //  1. a node of level d is assumed to have the average n_child
+        //     of the nodes read at level d
+        //  2. leaves are assumed as full as the non-root internal nodes read,
+        //     and lo and hi in the middle of their leaves
+        long long estimate_range(const Key &lo, const Key &hi)
+        {
+            if (lo > hi)
+                return 0;
+            Node x;
+            if (leaf_depth < 0)
+            {
+                leaf_depth = 0;
+                for (x.load(file, root_offset); x.node_type != NodeType::Leaf;
+                     x.load(file, x.child(0)))
+                    leaf_depth++;
+            }
+            if (leaf_depth == 0)
+            {
+                x.load(file, root_offset);
+                int k = x.find(hi);
+                return k - x.find(lo) + (k < x.n_key && x.keyAt(k) == hi);
+            }
+
+            // paths of lo and hi, which share nodes above level split
+            int lo_slot[MAX_HEIGHT], lo_child[MAX_HEIGHT];
+            int hi_slot[MAX_HEIGHT], hi_child[MAX_HEIGHT];
+            double fanout[MAX_HEIGHT + 1];
+            int split = leaf_depth;
+            long long n_child = 0, capacity = 0; // of non-root nodes
+            int lo_offset = root_offset, hi_offset = root_offset;
+            for (int d = 0; d < leaf_depth; ++d)
+            {
+                x.load(file, lo_offset);
+                lo_slot[d] = x.find(lo), lo_child[d] = x.n_key + 1;
+                lo_offset = x.child(lo_slot[d]);
+                if (split == leaf_depth)
+                {
+                    hi_slot[d] = x.find(hi), hi_child[d] = lo_child[d];
+                    hi_offset = x.child(hi_slot[d]);
+                    if (hi_slot[d] != lo_slot[d])
+                        split = d;
+                }
+                else
+                {
+                    x.load(file, hi_offset);
+                    hi_slot[d] = x.find(hi), hi_child[d] = x.n_key + 1;
+                    hi_offset = x.child(hi_slot[d]);
+                }
+                int n_node = d > split ? 2 : 1;
+                fanout[d] = (double)(lo_child[d] + (n_node == 2 ? hi_child[d] : 0)) / n_node;
+                if (d > 0)
+                    n_child += lo_child[d] + (n_node == 2 ? hi_child[d] : 0),
+                        capacity += n_node * Node::MAX_M;
+            }
+
+            // size[d]: keys of a subtree rooted at level d
+            double size[MAX_HEIGHT + 1];
+            double fill = capacity > 0 ? (double)n_child / capacity : 0.7;
+            size[leaf_depth] = fill * Node::FIT_L;
+            for (int d = leaf_depth - 1; d >= 0; --d)
+                size[d] = fanout[d] * size[d + 1];
+            if (split == leaf_depth)
+                return (long long)(size[leaf_depth] / 2 + 0.5);
+            // children between the two paths, then the halves of both leaves
+            double n = (hi_slot[split] - lo_slot[split] - 1) * size[split + 1] + size[leaf_depth];
+            for (int d = split + 1; d < leaf_depth; ++d)
+                n += (lo_child[d] - lo_slot[d] - 1 + hi_slot[d]) * size[d + 1];
+            return (long long)(n + 0.5);
+        }
+
+        // >>>>> bulk load
+        // build the tree bottom-up from sorted unique (key, value)s
+        //  every level keeps its open node and the left brother in memory,
+        //  so that the last node can borrow from its left brother
+        // NOTE: the tree is cleared at construction,
+        //  and cannot be used until finish()
+        class bulk_loader
+        {
+        private:
+            struct Level
+            {
+                Node node[2]; // node[0]: left brother, node[1]: open node
+                Key max_key[2];
+                bool has_left;
+            };
+
+            BTree *tree_ptr;
+            Level *level;
+            int height;
+            int leaf_fill;  // max n_key of leaf
+            int child_fill; // max n_child of internal node
+
+            int allocate()
+            {
+                return tree_ptr->current_offset += BLOCK_SIZE;
+            }
+
+            // save node[i] of level[d] and append it to level[d + 1]
+            void emit(int d, int i)
+            {
+                Level &l = level[d];
+                l.node[i].save(tree_ptr->file);
+                appendChild(d + 1, l.max_key[i], l.node[i].byte_offset);
+            }
+
+            // the open node of level[d] becomes the left brother
+            void shift(int d)
+            {
+                Level &l = level[d];
+                if (l.has_left)
+                    emit(d, 0);
+                l.node[0] = l.node[1];
+                l.max_key[0] = l.max_key[1];
+                l.has_left = true;
+                l.node[1] = Node(l.node[0].node_type, allocate());
+                if (d == 0)
+                {
+                    // link sequential node
+                    l.node[0].succ_offset = l.node[1].byte_offset;
+                    l.node[1].prev_offset = l.node[0].byte_offset;
+                }
+            }
+
+            // shift(0), but a packed leaf keeps the longest prefix fitting in its page
+            //  and the rest is moved to the open leaf, which always fits
+            void shiftLeaf()
+            {
+                Level &l = level[0];
+                int n_key = l.node[1].n_key, lo = n_key;
+                if (l.node[1].isOverflow())
+                {
+                    // the first n_key overflowing in [FIT_L + 1, n_key]
+                    lo = Node::FIT_L + 1;
+                    for (int hi = n_key; lo < hi;)
+                    {
+                        l.node[1].n_key = (lo + hi) >> 1;
+                        if (l.node[1].isOverflow())
+                            hi = l.node[1].n_key;
+                        else
+                            lo = l.node[1].n_key + 1;
+                    }
+                    lo--;
+                }
+                l.node[1].n_key = lo;
+                l.max_key[1] = l.node[1].key(lo - 1);
+                shift(0);
+                for (int i = lo; i < n_key; ++i)
+                    l.node[1].insertData(i - lo, l.node[0].key(i), l.node[0].value(i));
+                if (lo < n_key)
+                    l.max_key[1] = l.node[1].key(n_key - lo - 1);
+            }
+
+            void appendChild(int d, const Key &max_key, int child_offset)
+            {
+                if (d == height)
+                {
+                    // grow taller
+                    if (height == MAX_HEIGHT)
+                        throw runtime_error();
+                    level[height++].has_left = false;
+                    level[d].node[1] = Node(NodeType::Internal, allocate());
+                }
+                else if (level[d].node[1].n_key + 1 == child_fill)
+                    shift(d);
+                else
+                {
+                    Node &x = level[d].node[1];
+                    x.key(x.n_key) = level[d].max_key[1];
+                    x.n_key++;
+                }
+                Node &x = level[d].node[1];
+                x.child(x.n_key) = child_offset;
+                level[d].max_key[1] = max_key;
+            }
+
+            // the open node of level[d] borrows from its left brother
+            void balance(int d)
+            {
+                Level &l = level[d];
+                Node &left = l.node[0], &x = l.node[1];
+                if (x.node_type == NodeType::Leaf)
+                {
+                    while (x.isUnderflow() && left.n_key > x.n_key)
+                    {
+                        left.n_key--;
+                        x.insertData(0, left.key(left.n_key), left.value(left.n_key));
+                        l.max_key[0] = left.key(left.n_key - 1);
+                    }
+                    return;
+                }
+                while (x.isUnderflow() && left.n_key > x.n_key)
+                {
+                    x.insertChild(0, 0, l.max_key[0], left.child(left.n_key));
+                    l.max_key[0] = left.key(left.n_key - 1);
+                    left.n_key--;
+                }
+            }
+
+        public:
+            bulk_loader(BTree *tree_ptr, int fill_percent = 100)
+                : tree_ptr(tree_ptr), height(0)
+            {
+                tree_ptr->checkWritable();
+                if (ftruncate(tree_ptr->file.fd, 0) != 0)
+                    throw runtime_error();
+                if (tree_ptr->cache != nullptr)
+                    tree_ptr->cache->clear();
+                tree_ptr->current_offset = 0;
+                leaf_fill = Node::MAX_L * fill_percent / 100;
+                if (leaf_fill < Node::MIN_L)
+                    leaf_fill = Node::MIN_L;
+                child_fill = Node::MAX_M * fill_percent / 100;
+                if (child_fill < ((Node::MAX_M - 1) >> 1) + 2)
+                    child_fill = ((Node::MAX_M - 1) >> 1) + 2;
+                level = new Level[MAX_HEIGHT];
+            }
+            bulk_loader(const bulk_loader &other) = delete;
+            bulk_loader &operator=(const bulk_loader &other) = delete;
+
+            ~bulk_loader() { delete[] level; }
+
+            // NOTE: key must be greater than all appended keys
+            void append(const Key &key, const Value &value)
+            {
+                if (height == 0)
+                {
+                    height = 1;
+                    level[0].has_left = false;
+                    level[0].node[1] = Node(NodeType::Leaf, allocate());
+                    tree_ptr->seq_head = level[0].node[1].byte_offset;
+                }
+                else if (!(key > level[0].max_key[1]))
+                    throw runtime_error();
+                else if (level[0].node[1].n_key == leaf_fill)
+                    shiftLeaf();
+                Node &x = level[0].node[1];
+                x.insertData(x.n_key, key, value);
+                level[0].max_key[1] = key;
+            }
+
+            void finish()
+            {
+                if (height == 0)
+                {
+                    tree_ptr->reset();
+                    return;
+                }
+                if (level[0].node[1].isOverflow())
+                    shiftLeaf();
+                tree_ptr->seq_tail = level[0].node[1].byte_offset;
+                for (int d = 0;; ++d)
+                {
+                    Level &l = level[d];
+                    if (!l.has_left)
+                    {
+                        // the only node of top level
+                        l.node[1].save(tree_ptr->file);
+                        tree_ptr->root_offset = l.node[1].byte_offset;
+                        tree_ptr->leaf_depth = d;
+                        break;
+                    }
+                    balance(d);
+                    emit(d, 0), emit(d, 1);
+                }
+                tree_ptr->saveHeader();
+            }
+        };
+
+        void setLazyMerge(bool is_lazy_merge)
+        {
+            this->is_lazy_merge = is_lazy_merge;
+        }
+
+        // cache at() in about n_entry entries, 0 to turn it off
+        //  insert, modify and erase write through the cache
+        // NOTE: ReadOnly trees drop the cache when refresh() finds a new version,
+        //  writes of other processes in between are not seen
+        void setCache(int n_entry)
+        {
+            static_assert(IsHashable<Key>::value, "setCache() needs a scalar Key or Key::hash(h)");
+            delete cache;
+            cache = n_entry > 0 ? new HotCache<Key, Value>(n_entry) : nullptr;
+        }
+
+        // batched pass of lazy merge
+        //  rebuild the tree from its leaves in a new file,
+        //  which is renamed over file_path, so that dead pages are dropped
+        void compact(int fill_percent = 100)
+        {
+            checkWritable();
+            char new_path[sizeof(file_path) + 8];
+            strcpy(new_path, file_path);
+            strcat(new_path, ".compact");
+            {
+                BTree other(new_path);
+                bulk_loader loader(&other, fill_percent);
+                for (cursor it = seekBegin(); it.valid(); ++it)
+                    loader.append(it.getKey(), it.getValue());
+                loader.finish();
+                other.generation = generation;
+                addStats(other);
+            }
+            if (rename(new_path, file_path) != 0)
+                throw runtime_error();
+            close(file.fd);
+            file.fd = ::open(file_path, O_RDWR);
+            if (file.fd == -1)
+                throw runtime_error();
+            loadHeader();
+        }
+        // <<<<< bulk load
+    };
+
+    // B+ tree allowing duplicate keys, e.g. as a secondary index
+    //  1. entries are ordered by (key, value), so that duplicate keys can span leaves
+    //  2. a leaf record stores key once followed by a posting list of
+    //     at most POSTING_SIZE sorted values (POSTING_SIZE = 1: one record per pair)
+    // NOTE: Value should support "<" and "=="
+    template <class Key, class Value, int POSTING_SIZE = 1>
+    class MultiBTree
+    {
+    private:
+        // (key, values[0]) of a record
+        struct Entry
+        {
+            Key key;
+            Value value;
+
+            Entry() {}
+            Entry(const Key &key, const Value &value) : key(key), value(value) {}
+
+            unsigned long long hash(unsigned long long h) const
+            {
+                return hashKey(value, hashKey(key, h));
+            }
+
+            friend bool operator==(const Entry &lhs, const Entry &rhs)
+            {
+                return lhs.key == rhs.key && lhs.value == rhs.value;
+            }
+            friend bool operator!=(const Entry &lhs, const Entry &rhs)
+            {
+                return !(lhs == rhs);
+            }
+            friend bool operator>(const Entry &lhs, const Entry &rhs)
+            {
+                return lhs.key > rhs.key ||
+                       (lhs.key == rhs.key && rhs.value < lhs.value);
+            }
+            // NOTE: a bare key is compared with Entry::key only,
+            //  which makes BTree::find() return the first record of the key
+            friend bool operator==(const Entry &lhs, const Key &rhs) { return lhs.key == rhs; }
+            friend bool operator>(const Key &lhs, const Entry &rhs) { return lhs > rhs.key; }
+        };
+
+        struct Posting
+        {
+            int n_value;
+            Value values[POSTING_SIZE];
+
+            Posting() : n_value(0) {}
+
+            // returns: k
+            //  values[k - 1] < value <= values[k]
+            int find(const Value &value) const
+            {
+                int k = 0;
+                while (k < n_value && values[k] < value)
+                    k++;
+                return k;
+            }
+        };
+
+        typedef typename BTree<Entry, Posting>::iterator record_iterator;
+
+        BTree<Entry, Posting> tree;
+
+        // the record whose range may contain (key, value)
+        //  returns: <is_found, iterator>
+        pair<bool, record_iterator> locate(const Key &key, const Value &value)
+        {
+            Entry target(key, value);
+            record_iterator it = tree.lower_bound(target);
+            if (it != tree.end() && it.getKey() == target)
+                return pair<bool, record_iterator>(true, it);
+            if (it == tree.begin())
+                return pair<bool, record_iterator>(false, it);
+            --it;
+            return pair<bool, record_iterator>(it.getKey().key == key, it);
+        }
+
+    public:
+        MultiBTree() : tree("multi_tree_data.bin") {}
+
+        MultiBTree(const char *fname, OpenMode open_mode = OpenMode::ReadWrite)
+            : tree(fname, open_mode) {}
+
+        bool refresh() { return tree.refresh(); }
+
+        void setLazyMerge(bool is_lazy_merge) { tree.setLazyMerge(is_lazy_merge); }
+
+        void compact(int fill_percent = 100) { tree.compact(fill_percent); }
+
+        void clear() { tree.clear(); }
+
+        // returns false if (key, value) already exists
+        bool insert(const Key &key, const Value &value)
+        {
+            pair<bool, record_iterator> result = locate(key, value);
+            if (result.first)
+            {
+                // key[0] <= value < key[0] of the next record
+                record_iterator it = result.second;
+                Posting x = it.getValue();
+                int k = x.find(value);
+                if (k < x.n_value && x.values[k] == value)
+                    return false;
+                if (x.n_value < POSTING_SIZE)
+                {
+                    for (int i = x.n_value; i > k; --i)
+                        x.values[i] = x.values[i - 1];
+                    x.values[k] = value, x.n_value++;
+                    it.modify(x);
+                    return true;
+                }
+
+                // split posting list into x & succ
+                Value buffer[POSTING_SIZE + 1];
+                for (int i = 0, j = 0; i <= POSTING_SIZE; ++i)
+                    buffer[i] = i == k ? value : x.values[j++];
+                Posting succ;
+                x.n_value = (POSTING_SIZE + 1) >> 1;
+                succ.n_value = POSTING_SIZE + 1 - x.n_value;
+                for (int i = 0; i < x.n_value; ++i)
+                    x.values[i] = buffer[i];
+                for (int i = 0; i < succ.n_value; ++i)
+                    succ.values[i] = buffer[x.n_value + i];
+                it.modify(x);
+                return tree.insert(Entry(key, succ.values[0]), succ);
+            }
+
+            // value is smaller than any value of key
+            //  prepend to the first record if possible
+            record_iterator it = tree.lower_bound(key);
+            if (it != tree.end())
+            {
+                Entry first = it.getKey();
+                Posting x = it.getValue();
+                if (first.key == key && x.n_value < POSTING_SIZE)
+                {
+                    tree.erase(first);
+                    for (int i = x.n_value; i > 0; --i)
+                        x.values[i] = x.values[i - 1];
+                    x.values[0] = value, x.n_value++;
+                    return tree.insert(Entry(key, value), x);
+                }
+            }
+            Posting x;
+            x.values[x.n_value++] = value;
+            return tree.insert(Entry(key, value), x);
+        }
+
+        // remove a specific (key, value) pair
+        bool erase(const Key &key, const Value &value)
+        {
+            pair<bool, record_iterator> result = locate(key, value);
+            if (!result.first)
+                return false;
+
+            record_iterator it = result.second;
+            Entry first = it.getKey();
+            Posting x = it.getValue();
+            int k = x.find(value);
+            if (k == x.n_value || !(x.values[k] == value))
+                return false;
+            x.n_value--;
+            for (int i = k; i < x.n_value; ++i)
+                x.values[i] = x.values[i + 1];
+
+            if (k > 0)
+                it.modify(x);
+            else
+            {
+                // values[0] changes, so does the order of record
+                tree.erase(first);
+                if (x.n_value > 0)
+                    tree.insert(Entry(key, x.values[0]), x);
+            }
+            return true;
+        }
+
+        // iterate all values of a key in ascending order
+        class range_cursor
+        {
+            friend class MultiBTree;
+
+        private:
+            Key key;
+            typename BTree<Entry, Posting>::cursor record;
+            Posting x;
+            int k;
+
+            // load the posting list of current record
+            //  (invalid once the key changes)
+            void settle()
+            {
+                k = 0, x.n_value = 0;
+                if (record.valid() && record.getKey().key == key)
+                    x = record.getValue();
+            }
+
+            range_cursor(const Key &key,
+                         const typename BTree<Entry, Posting>::cursor &record)
+                : key(key), record(record)
+            {
+                settle();
+            }
+
+        public:
+            bool valid() const { return k < x.n_value; }
+
+            Value getValue() const { return x.values[k]; }
+
+            range_cursor &operator++()
+            {
+                if (!valid())
+                    throw invalid_iterator();
+                if (++k == x.n_value)
+                    ++record, settle();
+                return *this;
+            }
+        };
+
+        range_cursor equal_range(const Key &key)
+        {
+            return range_cursor(key, tree.seek(key));
+        }
     };
 
 } // namespace sjtu
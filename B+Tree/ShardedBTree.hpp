@@ -0,0 +1,488 @@
+#ifndef SJTU_SHARDED_BTREE_HPP
+#define SJTU_SHARDED_BTREE_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "BTree.hpp"
+
+namespace sjtu
+{
+    enum Partition
+    {
+        HashPartition,
+        // shard i holds keys in (bounds[i - 1], bounds[i]]
+        RangePartition,
+    };
+
+    // N independent BTree files, prefix.0 ... prefix.(N - 1)
+    //  every shard is written by its own thread through a bounded queue
+    // NOTE:
+    //  1. insert, modify, erase and clear are asynchronous,
+    //     flush() waits until every queued request is done
+    //  2. at() is queued as well, so it sees every write issued before it
+    //  3. a cursor reads shards directly after flush(),
+    //     no write should be issued while a cursor is in use
+    //  4. once an operation of a shard throws, later requests of the shard are dropped,
+    //     and every synchronous call (at(), flush() ...) touching it rethrows the exception
+    template <class Key, class Value, class Hash = std::hash<Key>>
+    class ShardedBTree
+    {
+    private:
+        typedef BTree<Key, Value> Tree;
+
+        enum OpType
+        {
+            Insert,
+            Modify,
+            Erase,
+            Query,
+            BatchInsert,
+            BatchErase,
+            Clear,
+            Barrier,
+            Stop,
+        };
+
+        // filled in by the writer of a synchronous request
+        struct Reply
+        {
+            bool is_done;
+            Value value;
+
+            Reply() : is_done(false) {}
+        };
+
+        struct Request
+        {
+            OpType type;
+            Key key;
+            Value value;
+            pair<Key, Value> *batch; // owned by the request, freed by the writer
+            int n_batch;
+            Reply *reply;
+        };
+
+        struct Shard
+        {
+            Tree *tree;
+            std::thread writer;
+            std::mutex mutex;
+            std::condition_variable not_empty, not_full, done;
+            // ring buffer of requests
+            Request *queue;
+            int head, size;
+            bool is_failed; // a BTree operation has thrown
+            std::exception_ptr error; // the first exception thrown, set once is_failed
+        };
+
+        Shard *shards;
+        int n_shard, queue_size;
+        Partition partition;
+        Key *bounds; // n_shard - 1 increasing keys of RangePartition
+        Hash hash;
+
+        int shardOf(const Key &key) const
+        {
+            if (partition == Partition::HashPartition)
+                return hash(key) % n_shard;
+            // the first bound not less than key
+            int lo = 0, hi = n_shard - 1;
+            while (lo < hi)
+            {
+                int mid = (lo + hi) >> 1;
+                if (key > bounds[mid])
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+        void push(int i, const Request &request)
+        {
+            Shard &shard = shards[i];
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            shard.not_full.wait(lock, [&] { return shard.size < queue_size; });
+            shard.queue[(shard.head + shard.size++) % queue_size] = request;
+            shard.not_empty.notify_one();
+        }
+
+        Request makeRequest(OpType type)
+        {
+            Request request;
+            request.type = type;
+            request.batch = nullptr;
+            request.n_batch = 0;
+            request.reply = nullptr;
+            return request;
+        }
+
+        // push a request, then wait for its reply
+        void call(int i, Request request, Reply &reply)
+        {
+            request.reply = &reply;
+            push(i, request);
+            Shard &shard = shards[i];
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            shard.done.wait(lock, [&] { return reply.is_done; });
+            if (shard.is_failed)
+                std::rethrow_exception(shard.error);
+        }
+
+        void apply(Shard &shard, Request &request)
+        {
+            switch (request.type)
+            {
+            case OpType::Insert:
+                shard.tree->insert(request.key, request.value);
+                break;
+            case OpType::Modify:
+                shard.tree->modify(request.key, request.value);
+                break;
+            case OpType::Erase:
+                shard.tree->erase(request.key);
+                break;
+            case OpType::Query:
+                request.reply->value = shard.tree->at(request.key);
+                break;
+            case OpType::BatchInsert:
+                for (int i = 0; i < request.n_batch; ++i)
+                    shard.tree->insert(request.batch[i].first, request.batch[i].second);
+                break;
+            case OpType::BatchErase:
+                for (int i = 0; i < request.n_batch; ++i)
+                    shard.tree->erase(request.batch[i].first);
+                break;
+            case OpType::Clear:
+                shard.tree->clear();
+                break;
+            default:
+                break;
+            }
+        }
+
+        // writer thread of shards[i]
+        void serve(int i)
+        {
+            Shard &shard = shards[i];
+            while (true)
+            {
+                Request request;
+                {
+                    std::unique_lock<std::mutex> lock(shard.mutex);
+                    shard.not_empty.wait(lock, [&] { return shard.size > 0; });
+                    request = shard.queue[shard.head];
+                    shard.head = (shard.head + 1) % queue_size;
+                    shard.size--;
+                    shard.not_full.notify_one();
+                }
+                try
+                {
+                    if (!shard.is_failed)
+                        apply(shard, request);
+                }
+                catch (...)
+                {
+                    // NOTE: anything escaping serve() would terminate the process
+                    shard.error = std::current_exception();
+                    shard.is_failed = true;
+                }
+                delete[] request.batch;
+                if (request.reply != nullptr)
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    request.reply->is_done = true;
+                    shard.done.notify_all();
+                }
+                if (request.type == OpType::Stop)
+                    return;
+            }
+        }
+
+        // split n (key, value)s by shard, one request per shard
+        void batch(OpType type, const pair<Key, Value> *data, int n)
+        {
+            int *count = new int[n_shard]();
+            for (int i = 0; i < n; ++i)
+                count[shardOf(data[i].first)]++;
+            Request *requests = new Request[n_shard];
+            for (int i = 0; i < n_shard; ++i)
+            {
+                requests[i] = makeRequest(type);
+                requests[i].batch = count[i] > 0 ? new pair<Key, Value>[count[i]] : nullptr;
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                Request &request = requests[shardOf(data[i].first)];
+                request.batch[request.n_batch].first = data[i].first;
+                request.batch[request.n_batch].second = data[i].second;
+                request.n_batch++;
+            }
+            for (int i = 0; i < n_shard; ++i)
+                if (count[i] > 0)
+                    push(i, requests[i]);
+            delete[] requests;
+            delete[] count;
+        }
+
+        // stop the first n_writer writers, then free every shard
+        //  shards may be partly built, see the constructor
+        void release(int n_writer)
+        {
+            for (int i = 0; i < n_writer; ++i)
+                push(i, makeRequest(OpType::Stop));
+            for (int i = 0; i < n_writer; ++i)
+                shards[i].writer.join();
+            if (shards != nullptr)
+                for (int i = 0; i < n_shard; ++i)
+                {
+                    delete shards[i].tree;
+                    delete[] shards[i].queue;
+                }
+            delete[] shards;
+            delete[] bounds;
+        }
+
+    public:
+        // bounds: n_shard - 1 increasing keys, for RangePartition only
+        // NOTE: if a shard cannot be opened, the shards built so far are released, then it throws
+        ShardedBTree(const char *prefix, int n_shard,
+                     Partition partition = Partition::HashPartition,
+                     const Key *bounds = nullptr, int queue_size = 1024)
+            : shards(nullptr), n_shard(n_shard), queue_size(queue_size),
+              partition(partition), bounds(nullptr)
+        {
+            if (n_shard <= 0 || queue_size <= 0 ||
+                (partition == Partition::RangePartition && n_shard > 1 && bounds == nullptr))
+                throw runtime_error();
+            int n_writer = 0;
+            try
+            {
+                if (partition == Partition::RangePartition)
+                {
+                    this->bounds = new Key[n_shard];
+                    for (int i = 0; i + 1 < n_shard; ++i)
+                        this->bounds[i] = bounds[i];
+                }
+                shards = new Shard[n_shard];
+                for (int i = 0; i < n_shard; ++i)
+                {
+                    shards[i].tree = nullptr;
+                    shards[i].queue = nullptr;
+                    shards[i].head = shards[i].size = 0;
+                    shards[i].is_failed = false;
+                }
+                for (int i = 0; i < n_shard; ++i)
+                {
+                    char file_path[200];
+                    snprintf(file_path, sizeof(file_path), "%s.%d", prefix, i);
+                    shards[i].tree = new Tree(file_path);
+                    shards[i].queue = new Request[queue_size];
+                }
+                for (; n_writer < n_shard; ++n_writer)
+                    shards[n_writer].writer = std::thread(&ShardedBTree::serve, this, n_writer);
+            }
+            catch (...)
+            {
+                release(n_writer);
+                throw;
+            }
+        }
+        ShardedBTree(const ShardedBTree &other) = delete;
+        ShardedBTree &operator=(const ShardedBTree &other) = delete;
+
+        ~ShardedBTree() { release(n_shard); }
+
+        int shardCount() const { return n_shard; }
+
+        void insert(const Key &key, const Value &value)
+        {
+            Request request = makeRequest(OpType::Insert);
+            request.key = key, request.value = value;
+            push(shardOf(key), request);
+        }
+
+        void modify(const Key &key, const Value &value)
+        {
+            Request request = makeRequest(OpType::Modify);
+            request.key = key, request.value = value;
+            push(shardOf(key), request);
+        }
+
+        void erase(const Key &key)
+        {
+            Request request = makeRequest(OpType::Erase);
+            request.key = key;
+            push(shardOf(key), request);
+        }
+
+        // one request per shard
+        void insert(const pair<Key, Value> *data, int n) { batch(OpType::BatchInsert, data, n); }
+
+        // NOTE: values of data are ignored
+        void erase(const pair<Key, Value> *data, int n) { batch(OpType::BatchErase, data, n); }
+
+        void clear()
+        {
+            for (int i = 0; i < n_shard; ++i)
+                push(i, makeRequest(OpType::Clear));
+        }
+
+        Value at(const Key &key)
+        {
+            Request request = makeRequest(OpType::Query);
+            request.key = key;
+            Reply reply;
+            call(shardOf(key), request, reply);
+            return reply.value;
+        }
+
+        // wait until every queued request is done
+        //  rethrows the exception of the first failed shard, if any
+        void flush()
+        {
+            Reply *replies = new Reply[n_shard];
+            for (int i = 0; i < n_shard; ++i)
+            {
+                Request request = makeRequest(OpType::Barrier);
+                request.reply = &replies[i];
+                push(i, request);
+            }
+            int failed = -1;
+            for (int i = 0; i < n_shard; ++i)
+            {
+                std::unique_lock<std::mutex> lock(shards[i].mutex);
+                shards[i].done.wait(lock, [&] { return replies[i].is_done; });
+                if (failed == -1 && shards[i].is_failed)
+                    failed = i;
+            }
+            delete[] replies;
+            if (failed != -1)
+                std::rethrow_exception(shards[failed].error);
+        }
+
+        // sum over shards, after flush()
+        Stats stats()
+        {
+            flush();
+            Stats result;
+            for (int i = 0; i < n_shard; ++i)
+                result += shards[i].tree->stats();
+            return result;
+        }
+
+        void resetStats()
+        {
+            flush();
+            for (int i = 0; i < n_shard; ++i)
+                shards[i].tree->resetStats();
+        }
+
+        // k-way merge of shard cursors
+        //  a binary heap of shards, ordered by their current keys
+        class cursor
+        {
+            friend class ShardedBTree;
+
+        private:
+            typedef typename Tree::cursor shard_cursor;
+
+            shard_cursor **shards;
+            int *heap;
+            int n_heap, n_shard;
+
+            bool less(int a, int b) { return shards[b]->getKey() > shards[a]->getKey(); }
+
+            void siftDown(int k)
+            {
+                while (true)
+                {
+                    int t = k, l = k * 2 + 1, r = k * 2 + 2;
+                    if (l < n_heap && less(heap[l], heap[t]))
+                        t = l;
+                    if (r < n_heap && less(heap[r], heap[t]))
+                        t = r;
+                    if (t == k)
+                        return;
+                    int x = heap[t];
+                    heap[t] = heap[k], heap[k] = x;
+                    k = t;
+                }
+            }
+
+            // takes shard cursors, allocated by new
+            cursor(shard_cursor **shards, int n_shard)
+                : shards(shards), heap(new int[n_shard]), n_heap(0), n_shard(n_shard)
+            {
+                for (int i = 0; i < n_shard; ++i)
+                    if (shards[i]->valid())
+                        heap[n_heap++] = i;
+                for (int k = n_heap / 2 - 1; k >= 0; --k)
+                    siftDown(k);
+            }
+
+        public:
+            cursor(cursor &&other)
+                : shards(other.shards), heap(other.heap),
+                  n_heap(other.n_heap), n_shard(other.n_shard)
+            {
+                other.shards = nullptr, other.heap = nullptr;
+                other.n_shard = 0;
+            }
+            cursor(const cursor &other) = delete;
+            cursor &operator=(const cursor &other) = delete;
+
+            ~cursor()
+            {
+                for (int i = 0; i < n_shard; ++i)
+                    delete shards[i];
+                delete[] shards;
+                delete[] heap;
+            }
+
+            bool valid() const { return n_heap > 0; }
+
+            Key getKey() { return shards[heap[0]]->getKey(); }
+
+            Value getValue() { return shards[heap[0]]->getValue(); }
+
+            cursor &operator++()
+            {
+                if (!valid())
+                    throw invalid_iterator();
+                shard_cursor &top = *shards[heap[0]];
+                ++top;
+                if (!top.valid())
+                    heap[0] = heap[--n_heap];
+                siftDown(0);
+                return *this;
+            }
+        };
+
+        // return a cursor at lower_bound(key) of all shards
+        cursor seek(const Key &key)
+        {
+            flush();
+            typename cursor::shard_cursor **cursors =
+                new typename cursor::shard_cursor *[n_shard];
+            for (int i = 0; i < n_shard; ++i)
+                cursors[i] = new typename cursor::shard_cursor(shards[i].tree->seek(key));
+            return cursor(cursors, n_shard);
+        }
+
+        // return a cursor at the least key of all shards
+        cursor seekBegin()
+        {
+            flush();
+            typename cursor::shard_cursor **cursors =
+                new typename cursor::shard_cursor *[n_shard];
+            for (int i = 0; i < n_shard; ++i)
+                cursors[i] = new typename cursor::shard_cursor(shards[i].tree->seekBegin());
+            return cursor(cursors, n_shard);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,498 @@
+// reproducible benchmark of BTree
+//  g++ -O2 -std=c++14 bench.cpp -o bench
+//  ./bench [-n keys] [-w workload] [-c warm|cold] [-r read_percent]
+//          [-l scan_length] [-s seed] [-f file] [-t max_shard] [-j result.json]
+//          [-k cache_entries] [-z zipf_theta] [-d distribution] [--lazy]
+// workloads: seq_insert, rand_insert, query_hit, query_miss, query_zipf,
+//            mixed, range_scan, erase, churn, bulk_load, sharded_insert, all
+//  query_zipf: query_hit with the rank of key ~ Zipf(zipf_theta),
+//      hot keys are scattered over the key space
+//  distribution: of the n keys of every workload, uniform, clustered or skewed,
+//      see keySet()
+//  cache_entries: BTree::setCache() of query and mixed workloads, 0 for none
+//  --lazy: BTree::setLazyMerge(true), erase is followed by a compact() row
+//  churn: erase the least key and insert a new greatest key by turns, 2n ops,
+//      once with eager merge and once with lazy merge followed by compact(),
+//      then the costs of both are compared
+//  sharded_insert: rand_insert into a ShardedBTree of 1, 2, 4, ..., max_shard shards,
+//      files are file.0, file.1, ...
+// NOTE: cold drops the pages of file (or file.0, file.1, ... of sharded_insert)
+//  from the OS page cache before every measured phase, by fdatasync + POSIX_FADV_DONTNEED
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "ShardedBTree.hpp"
+
+// compile with -DSEARCH=BinarySearch etc. to compare search policies
+//  and -DLAYOUT=PackedLeaf to compare leaf layouts
+#ifndef SEARCH
+#define SEARCH LinearSearch
+#endif
+#ifndef LAYOUT
+#define LAYOUT PlainLeaf
+#endif
+
+typedef sjtu::BTree<int, long long, sjtu::SEARCH, sjtu::LAYOUT> Tree;
+typedef sjtu::ShardedBTree<int, long long> ShardedTree;
+
+struct Config
+{
+    int n = 1000000;
+    std::string workload = "all";
+    bool is_cold = false;
+    int read_percent = 90;
+    int scan_length = 100;
+    unsigned seed = 2020;
+    std::string file_path = "bench_data.bin";
+    int max_shard = 16;
+    std::string json_path;
+    int cache_size = 0;
+    double zipf_theta = 0.99;
+    std::string distribution = "uniform";
+    bool is_lazy = false;
+};
+
+struct Result
+{
+    std::string workload;
+    long long n_op;
+    double second;
+    long long p50, p99, p999; // ns
+    double page_read, page_write; // per op
+    long long file_size;
+    double hit_rate; // of at() through cache
+};
+
+Config config;
+std::vector<int> keys; // n increasing even keys, so that odd keys miss
+std::vector<Result> results;
+int n_shard = 0; // of the ShardedTree under test, 0 for a Tree
+
+long long fileSize(const std::string &file_path)
+{
+    struct stat file_stat;
+    return stat(file_path.c_str(), &file_stat) == 0 ? file_stat.st_size : 0;
+}
+
+std::string shardPath(int i)
+{
+    return config.file_path + "." + std::to_string(i);
+}
+
+long long fileSize()
+{
+    long long size = n_shard == 0 ? fileSize(config.file_path) : 0;
+    for (int i = 0; i < n_shard; ++i)
+        size += fileSize(shardPath(i));
+    return size;
+}
+
+void dropCache(const std::string &file_path)
+{
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// of the tree under test, every shard of a ShardedTree
+void dropCache()
+{
+    if (n_shard == 0)
+        dropCache(config.file_path);
+    for (int i = 0; i < n_shard; ++i)
+        dropCache(shardPath(i));
+}
+
+// warm: read every reachable page once
+//  NOTE: the header of a new tree is written when it is destroyed
+void prepareCache(Tree &tree)
+{
+    if (config.is_cold)
+        dropCache();
+    else
+        tree.analyze();
+    tree.resetStats();
+}
+
+// a tree of all keys
+void buildBase(Tree &tree)
+{
+    Tree::bulk_loader loader(&tree);
+    for (int i = 0; i < config.n; ++i)
+        loader.append(keys[i], i);
+    loader.finish();
+}
+
+// time n_op calls of op(i), then record a Result
+//  TreeType is either Tree or ShardedTree
+template <class TreeType, class Op>
+void measure(const std::string &workload, TreeType &tree, long long n_op, Op op)
+{
+    std::vector<long long> latency(n_op);
+    auto start = std::chrono::steady_clock::now();
+    auto last = start;
+    for (long long i = 0; i < n_op; ++i)
+    {
+        op(i);
+        auto now = std::chrono::steady_clock::now();
+        latency[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+        last = now;
+    }
+    Result result;
+    result.workload = workload;
+    result.n_op = n_op;
+    result.second = std::chrono::duration<double>(last - start).count();
+    std::sort(latency.begin(), latency.end());
+    auto percentile = [&](double p) {
+        return n_op > 0 ? latency[std::min(n_op - 1, (long long)(p * n_op))] : 0;
+    };
+    result.p50 = percentile(0.5);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    sjtu::Stats stats = tree.stats();
+    result.page_read = n_op > 0 ? (double)stats.page_read / n_op : 0;
+    result.page_write = n_op > 0 ? (double)stats.page_write / n_op : 0;
+    result.file_size = fileSize();
+    result.hit_rate = stats.hitRate();
+    results.push_back(result);
+    printf("%-12s %10lld %12.0f %9lld %9lld %9lld %8.2f %8.2f %12lld %6.1f\n",
+           workload.c_str(), n_op, n_op / result.second,
+           result.p50, result.p99, result.p999,
+           result.page_read, result.page_write, result.file_size,
+           100 * result.hit_rate);
+    fflush(stdout);
+}
+
+std::vector<int> permutation(int n, std::mt19937 &rng)
+{
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    return order;
+}
+
+// m samples of [0, n), P(rank r) ~ 1 / (r + 1)^theta,
+//  ranks are mapped to values by a permutation
+std::vector<int> zipf(int n, long long m, double theta, std::mt19937 &rng)
+{
+    std::vector<double> cdf(n);
+    double sum = 0;
+    for (int i = 0; i < n; ++i)
+        cdf[i] = sum += 1 / pow(i + 1.0, theta);
+    std::vector<int> order = permutation(n, rng);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<int> result(m);
+    for (long long i = 0; i < m; ++i)
+    {
+        int rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        result[i] = order[std::min(rank, n - 1)];
+    }
+    return result;
+}
+
+// n increasing even keys, below 2^29 for n below 2^27
+//  gaps sum to at most 2^27 + n units of 2, see max_gap
+//  uniform: 0, 2, 4, ...
+//  clustered: runs of 64 adjacent even keys, separated by random gaps
+//  skewed: gaps follow a lognormal distribution, mostly small with a heavy tail
+// NOTE: the last two break the even spacing that interpolation and learned search assume
+std::vector<int> keySet(int n, const std::string &distribution, std::mt19937 &rng)
+{
+    const int CLUSTER_SIZE = 64;
+    int max_gap = std::max(1, (1 << 27) / std::max(n, 1));
+    std::lognormal_distribution<double> lognormal(0, 2);
+    std::vector<int> result(n);
+    int key = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        int gap = 1;
+        if (distribution == "clustered")
+            gap = i % CLUSTER_SIZE == 0 ? 1 + rng() % (max_gap * CLUSTER_SIZE) : 1;
+        else if (distribution == "skewed")
+            gap = 1 + (int)std::min<double>(lognormal(rng), max_gap - 1);
+        else if (distribution != "uniform")
+        {
+            fprintf(stderr, "unknown distribution: %s\n", distribution.c_str());
+            exit(1);
+        }
+        result[i] = key;
+        key += gap * 2;
+    }
+    return result;
+}
+
+// NOTE: inserts are asynchronous, the last op waits for all of them
+void runSharded()
+{
+    for (n_shard = 1; n_shard <= config.max_shard; n_shard <<= 1)
+    {
+        std::mt19937 rng(config.seed);
+        for (int i = 0; i < n_shard; ++i)
+            remove(shardPath(i).c_str());
+        int n = config.n;
+        std::vector<int> order = permutation(n, rng);
+        {
+            ShardedTree tree(config.file_path.c_str(), n_shard);
+            tree.resetStats();
+            // NOTE: after resetStats(), which flushes, so that no writer is busy
+            if (config.is_cold)
+                dropCache();
+            measure("sharded_" + std::to_string(n_shard), tree, n, [&](long long i) {
+                tree.insert(keys[order[i]], i);
+                if (i == n - 1)
+                    tree.flush();
+            });
+        }
+        for (int i = 0; i < n_shard; ++i)
+            remove(shardPath(i).c_str());
+    }
+    n_shard = 0;
+}
+
+// NOTE: ignores --lazy, runs both
+void runChurn()
+{
+    int n = config.n;
+    // NOTE: keys are below 2^29, keys[k] + span is below 2^30
+    int span = n > 0 ? keys[n - 1] + 2 : 0;
+    double second[2];
+    for (int is_lazy = 0; is_lazy < 2; ++is_lazy)
+    {
+        remove(config.file_path.c_str());
+        Tree tree(config.file_path.c_str());
+        tree.setLazyMerge(is_lazy);
+        buildBase(tree);
+        prepareCache(tree);
+        measure(is_lazy ? "churn_lazy" : "churn", tree, 2LL * n, [&](long long i) {
+            int k = (int)(i / 2);
+            if (i % 2 == 0)
+                tree.erase(keys[k]);
+            else
+                tree.insert(keys[k] + span, k);
+        });
+        second[is_lazy] = results.back().second;
+        if (is_lazy)
+        {
+            tree.resetStats();
+            measure("compact", tree, 1, [&](long long) { tree.compact(); });
+            second[is_lazy] += results.back().second;
+        }
+    }
+    printf("%-12s lazy merge + compact: %.3f s, eager merge: %.3f s (%.2fx)\n",
+           "churn", second[1], second[0], second[1] / second[0]);
+    fflush(stdout);
+}
+
+void run(const std::string &workload)
+{
+    if (workload == "sharded_insert")
+    {
+        runSharded();
+        return;
+    }
+    if (workload == "churn")
+    {
+        runChurn();
+        return;
+    }
+    std::mt19937 rng(config.seed);
+    remove(config.file_path.c_str());
+    Tree tree(config.file_path.c_str());
+    tree.setLazyMerge(config.is_lazy);
+    int n = config.n;
+
+    if (workload == "seq_insert" || workload == "rand_insert")
+    {
+        std::vector<int> order = permutation(n, rng);
+        if (workload == "seq_insert")
+            std::sort(order.begin(), order.end());
+        prepareCache(tree);
+        measure(workload, tree, n, [&](long long i) { tree.insert(keys[order[i]], i); });
+    }
+    else if (workload == "bulk_load")
+    {
+        prepareCache(tree);
+        Tree::bulk_loader loader(&tree);
+        measure(workload, tree, n, [&](long long i) {
+            loader.append(keys[i], i);
+            if (i == n - 1)
+                loader.finish();
+        });
+    }
+    else if (workload == "query_hit" || workload == "query_miss")
+    {
+        buildBase(tree);
+        int miss = workload == "query_miss";
+        tree.setCache(config.cache_size);
+        prepareCache(tree);
+        measure(workload, tree, n, [&](long long) { tree.at(keys[rng() % n] + miss); });
+    }
+    else if (workload == "query_zipf")
+    {
+        buildBase(tree);
+        std::vector<int> order = zipf(n, n, config.zipf_theta, rng);
+        tree.setCache(config.cache_size);
+        prepareCache(tree);
+        measure(workload, tree, n, [&](long long i) { tree.at(keys[order[i]]); });
+    }
+    else if (workload == "mixed")
+    {
+        // reads hit existing keys, writes insert odd keys
+        buildBase(tree);
+        std::vector<int> order = permutation(n, rng);
+        long long n_write = 0;
+        tree.setCache(config.cache_size);
+        prepareCache(tree);
+        measure(workload, tree, n, [&](long long) {
+            if ((int)(rng() % 100) < config.read_percent)
+                tree.at(keys[rng() % n]);
+            else
+            {
+                tree.insert(keys[order[n_write]] + 1, n_write);
+                n_write++;
+            }
+        });
+    }
+    else if (workload == "range_scan")
+    {
+        buildBase(tree);
+        int n_scan = std::max(1, n / config.scan_length);
+        long long sum = 0;
+        prepareCache(tree);
+        measure(workload, tree, n_scan, [&](long long) {
+            Tree::cursor it = tree.seek(keys[rng() % n]);
+            for (int i = 0; i < config.scan_length && it.valid(); ++i, ++it)
+                sum += it.getValue();
+        });
+        if (sum == -1)
+            printf("%lld\n", sum);
+    }
+    else if (workload == "erase")
+    {
+        buildBase(tree);
+        std::vector<int> order = permutation(n, rng);
+        prepareCache(tree);
+        measure(workload, tree, n, [&](long long i) { tree.erase(keys[order[i]]); });
+        if (config.is_lazy)
+        {
+            tree.resetStats();
+            measure("compact", tree, 1, [&](long long) { tree.compact(); });
+        }
+    }
+    else
+    {
+        fprintf(stderr, "unknown workload: %s\n", workload.c_str());
+        exit(1);
+    }
+}
+
+void writeJson()
+{
+    FILE *out = fopen(config.json_path.c_str(), "w");
+    if (out == nullptr)
+    {
+        fprintf(stderr, "cannot open %s\n", config.json_path.c_str());
+        exit(1);
+    }
+    fprintf(out, "{\n  \"n\": %d,\n  \"cache\": \"%s\",\n  \"read_percent\": %d,\n"
+                 "  \"scan_length\": %d,\n  \"seed\": %u,\n"
+                 "  \"cache_entries\": %d,\n  \"zipf_theta\": %.3f,\n  \"distribution\": \"%s\",\n"
+                 "  \"lazy\": %s,\n  \"results\": [\n",
+            config.n, config.is_cold ? "cold" : "warm", config.read_percent,
+            config.scan_length, config.seed, config.cache_size, config.zipf_theta,
+            config.distribution.c_str(), config.is_lazy ? "true" : "false");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result &r = results[i];
+        fprintf(out, "    {\"workload\": \"%s\", \"ops\": %lld, \"ops_per_sec\": %.1f, "
+                     "\"p50_ns\": %lld, \"p99_ns\": %lld, \"p999_ns\": %lld, "
+                     "\"page_read_per_op\": %.4f, \"page_write_per_op\": %.4f, "
+                     "\"file_bytes\": %lld, \"cache_hit_rate\": %.4f}%s\n",
+                r.workload.c_str(), r.n_op, r.n_op / r.second,
+                r.p50, r.p99, r.p999, r.page_read, r.page_write, r.file_size,
+                r.hit_rate, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--lazy")
+        {
+            config.is_lazy = true;
+            i--;
+            continue;
+        }
+        if (i + 1 == argc)
+        {
+            fprintf(stderr, "missing value of option: %s\n", option.c_str());
+            return 1;
+        }
+        std::string value = argv[i + 1];
+        if (option == "-n")
+            config.n = atoi(value.c_str());
+        else if (option == "-w")
+            config.workload = value;
+        else if (option == "-c")
+            config.is_cold = value == "cold";
+        else if (option == "-r")
+            config.read_percent = atoi(value.c_str());
+        else if (option == "-l")
+            config.scan_length = atoi(value.c_str());
+        else if (option == "-s")
+            config.seed = atoi(value.c_str());
+        else if (option == "-f")
+            config.file_path = value;
+        else if (option == "-t")
+            config.max_shard = atoi(value.c_str());
+        else if (option == "-j")
+            config.json_path = value;
+        else if (option == "-k")
+            config.cache_size = atoi(value.c_str());
+        else if (option == "-z")
+            config.zipf_theta = atof(value.c_str());
+        else if (option == "-d")
+            config.distribution = value;
+        else
+        {
+            fprintf(stderr, "unknown option: %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(config.seed);
+    keys = keySet(config.n, config.distribution, rng);
+
+    printf("%-12s %10s %12s %9s %9s %9s %8s %8s %12s %6s\n",
+           "workload", "ops", "ops/s", "p50(ns)", "p99(ns)", "p999(ns)",
+           "read/op", "write/op", "file(B)", "hit%");
+    const char *all[] = {"seq_insert", "rand_insert", "query_hit", "query_miss", "query_zipf",
+                         "mixed", "range_scan", "erase", "churn", "bulk_load", "sharded_insert"};
+    if (config.workload == "all")
+        for (const char *workload : all)
+            run(workload);
+    else
+        run(config.workload);
+    remove(config.file_path.c_str());
+
+    if (!config.json_path.empty())
+        writeJson();
+    return 0;
+}
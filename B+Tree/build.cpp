@@ -0,0 +1,524 @@
+// bulk build of a BTree file from unsorted "i key value" lines, see data/*/data_make.cpp
+//  g++ -O2 -std=c++14 -pthread build.cpp -o build
+//  ./build [-m memory_mb] [-j threads] [-d tmp_dir] [-p fill_percent] [-o file] [input]
+//      reads stdin if input is not given, writes tree_data.bin by default
+// external merge sort:
+//  1. the input is cut into runs of bounded size, which are sorted
+//     by -j threads and spilled to tmp_dir
+//  2. runs are merged by a heap, at most MAX_FAN_IN runs at a time,
+//     the final merge feeds BTree::bulk_loader from another thread
+// NOTE:
+//  1. as BTree::insert, the first line of a key wins, later ones are dropped
+//  2. 'q' lines are skipped, any other line is an error,
+//     since an erase cannot be reordered with inserts
+//  3. compile with -DKEY=... -DVALUE=... -DLAYOUT=... for other trees,
+//     KEY and VALUE must be integral
+// returns: 0 on success, 1 on bad input, 2 on I/O error
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "BTree.hpp"
+
+#ifndef KEY
+#define KEY int
+#endif
+#ifndef VALUE
+#define VALUE int
+#endif
+#ifndef LAYOUT
+#define LAYOUT PlainLeaf
+#endif
+
+typedef sjtu::BTree<KEY, VALUE, sjtu::LinearSearch, sjtu::LAYOUT> Tree;
+
+struct Record
+{
+    KEY key;
+    VALUE value;
+
+    bool operator<(const Record &other) const { return key < other.key; }
+};
+
+const int MAX_FAN_IN = 256;
+const int BUFFER_SIZE = 1 << 16; // of input, in bytes
+
+struct Config
+{
+    long long memory = 256ll << 20;
+    int n_thread = std::max(1u, std::thread::hardware_concurrency());
+    std::string tmp_dir = ".";
+    int fill_percent = 100;
+    const char *file_path = "tree_data.bin";
+    const char *input_path = nullptr;
+};
+
+Config config;
+
+void fail(int code, const char *message, const char *detail = "")
+{
+    fprintf(stderr, "build: %s%s\n", message, detail);
+    exit(code);
+}
+
+// >>>>> input
+// buffered scanner of integers
+class Scanner
+{
+private:
+    FILE *file;
+    char *buffer;
+    int pos, len;
+
+    int peek()
+    {
+        if (pos == len)
+        {
+            len = fread(buffer, 1, BUFFER_SIZE, file);
+            pos = 0;
+            if (len <= 0)
+            {
+                len = 0;
+                return EOF;
+            }
+        }
+        return buffer[pos];
+    }
+
+    int skipSpace()
+    {
+        int c = peek();
+        while (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+            pos++, c = peek();
+        return c;
+    }
+
+public:
+    long long n_line;
+
+    Scanner(FILE *file) : file(file), pos(0), len(0), n_line(0)
+    {
+        buffer = new char[BUFFER_SIZE];
+    }
+    ~Scanner() { delete[] buffer; }
+
+    // returns: the command, or EOF
+    int readCommand()
+    {
+        int c = skipSpace();
+        if (c != EOF)
+            pos++, n_line++;
+        return c;
+    }
+
+    template <class T>
+    bool readInt(T &x)
+    {
+        int c = skipSpace();
+        bool is_negative = c == '-';
+        if (is_negative)
+            pos++, c = peek();
+        if (c < '0' || c > '9')
+            return false;
+        x = 0;
+        for (; c >= '0' && c <= '9'; c = peek())
+            x = x * 10 + (c - '0'), pos++;
+        if (is_negative)
+            x = -x;
+        return true;
+    }
+};
+
+// fill run with at most capacity records
+//  returns: false if input is exhausted
+bool readRun(Scanner &scanner, std::vector<Record> &run, size_t capacity)
+{
+    run.clear();
+    while (run.size() < capacity)
+    {
+        int command = scanner.readCommand();
+        if (command == EOF)
+            return false;
+        Record record;
+        if (command == 'i')
+        {
+            if (!scanner.readInt(record.key) || !scanner.readInt(record.value))
+                fail(1, "bad line ", std::to_string(scanner.n_line).c_str());
+            run.push_back(record);
+        }
+        else if (command == 'q')
+        {
+            if (!scanner.readInt(record.key))
+                fail(1, "bad line ", std::to_string(scanner.n_line).c_str());
+        }
+        else
+            fail(1, "not an insert at line ", std::to_string(scanner.n_line).c_str());
+    }
+    return true;
+}
+
+// sort a run and drop later duplicates
+void sortRun(std::vector<Record> &run)
+{
+    std::stable_sort(run.begin(), run.end());
+    size_t n = 0;
+    for (size_t i = 0; i < run.size(); ++i)
+        if (n == 0 || run[n - 1].key < run[i].key)
+            run[n++] = run[i];
+    run.resize(n);
+}
+// <<<<< input
+
+// >>>>> runs
+std::string runPath(int id)
+{
+    return config.tmp_dir + "/build_run." + std::to_string(getpid()) + "." + std::to_string(id);
+}
+
+void writeRun(const std::string &path, const std::vector<Record> &run)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        fail(2, "cannot create ", path.c_str());
+    if (fwrite(run.data(), sizeof(Record), run.size(), file) != run.size())
+        fail(2, "cannot write ", path.c_str());
+    fclose(file);
+}
+
+// sequential reader of a spilled run
+class RunReader
+{
+private:
+    FILE *file;
+    Record *buffer;
+    size_t capacity, pos, len;
+
+public:
+    RunReader(const std::string &path, size_t capacity)
+        : capacity(capacity), pos(0), len(0)
+    {
+        file = fopen(path.c_str(), "rb");
+        if (file == nullptr)
+            fail(2, "cannot open ", path.c_str());
+        buffer = new Record[capacity];
+    }
+    RunReader(const RunReader &other) = delete;
+    RunReader &operator=(const RunReader &other) = delete;
+
+    ~RunReader()
+    {
+        fclose(file);
+        delete[] buffer;
+    }
+
+    // returns: nullptr at the end of run
+    const Record *peek()
+    {
+        if (pos == len)
+        {
+            len = fread(buffer, sizeof(Record), capacity, file);
+            pos = 0;
+            if (len == 0)
+                return nullptr;
+        }
+        return &buffer[pos];
+    }
+
+    void next() { pos++; }
+};
+
+// k-way merge of runs[lo, hi), the first of equal keys comes from the earliest run
+//  emit(record) is called in increasing key order, once per key
+template <class Emit>
+void merge(const std::vector<std::string> &runs, int lo, int hi, Emit emit)
+{
+    int k = hi - lo;
+    size_t capacity = std::max<size_t>(4096 / sizeof(Record), config.memory / 2 / k / sizeof(Record));
+    std::vector<RunReader *> readers;
+    for (int i = lo; i < hi; ++i)
+        readers.push_back(new RunReader(runs[i], capacity));
+
+    // heap of run indices, the smallest (key, index) on top
+    auto greater = [&](int a, int b) {
+        const Record *x = readers[a]->peek(), *y = readers[b]->peek();
+        return y->key < x->key || (!(x->key < y->key) && a > b);
+    };
+    std::vector<int> heap;
+    for (int i = 0; i < k; ++i)
+        if (readers[i]->peek() != nullptr)
+            heap.push_back(i);
+    std::make_heap(heap.begin(), heap.end(), greater);
+
+    bool has_last = false;
+    KEY last_key = KEY();
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        int i = heap.back();
+        const Record *record = readers[i]->peek();
+        if (!has_last || last_key < record->key)
+        {
+            emit(*record);
+            has_last = true;
+            last_key = record->key;
+        }
+        readers[i]->next();
+        if (readers[i]->peek() != nullptr)
+            std::push_heap(heap.begin(), heap.end(), greater);
+        else
+            heap.pop_back();
+    }
+    for (RunReader *reader : readers)
+        delete reader;
+    for (int i = lo; i < hi; ++i)
+        remove(runs[i].c_str());
+}
+// <<<<< runs
+
+// >>>>> pipeline
+// bounded queue of record blocks between two threads
+//  an empty block marks the end
+class BlockQueue
+{
+private:
+    std::mutex mutex;
+    std::condition_variable not_empty, not_full;
+    std::vector<std::vector<Record>> blocks;
+    size_t max_size;
+
+public:
+    BlockQueue(size_t max_size) : max_size(max_size) {}
+
+    void push(std::vector<Record> &block)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&] { return blocks.size() < max_size; });
+        blocks.push_back(std::move(block));
+        block.clear();
+        not_empty.notify_one();
+    }
+
+    void pop(std::vector<Record> &block)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [&] { return !blocks.empty(); });
+        block = std::move(blocks.front());
+        blocks.erase(blocks.begin());
+        not_full.notify_one();
+    }
+};
+
+// sort the input into runs, by n_thread threads
+//  returns: the only run in memory if input fits, otherwise paths of spilled runs
+std::vector<std::string> generateRuns(Scanner &scanner, size_t capacity, std::vector<Record> &only)
+{
+    std::vector<std::string> runs;
+    std::vector<Record> run;
+    run.reserve(capacity);
+    if (!readRun(scanner, run, capacity))
+    {
+        sortRun(run);
+        only.swap(run);
+        return runs;
+    }
+
+    // the reader fills a run while the workers sort and spill others
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::vector<Record>> pending; // with ids
+    std::vector<int> pending_id;
+    bool is_end = false;
+    auto work = [&]() {
+        while (true)
+        {
+            std::vector<Record> job;
+            int id;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return !pending.empty() || is_end; });
+                if (pending.empty())
+                    return;
+                job.swap(pending.back());
+                id = pending_id.back();
+                pending.pop_back(), pending_id.pop_back();
+                changed.notify_all();
+            }
+            sortRun(job);
+            writeRun(runPath(id), job);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.n_thread; ++i)
+        workers.emplace_back(work);
+
+    bool has_more = true;
+    for (int id = 0; !run.empty(); ++id)
+    {
+        runs.push_back(runPath(id));
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return pending.empty(); });
+            pending.push_back(std::vector<Record>());
+            pending.back().swap(run);
+            pending_id.push_back(id);
+            changed.notify_all();
+        }
+        if (has_more)
+        {
+            run.reserve(capacity);
+            has_more = readRun(scanner, run, capacity);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_end = true;
+        changed.notify_all();
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+    return runs;
+}
+
+// merge runs while there are more than MAX_FAN_IN
+//  consecutive runs are merged, so earlier lines still win
+void reduceRuns(std::vector<std::string> &runs)
+{
+    int next_id = runs.size();
+    while ((int)runs.size() > MAX_FAN_IN)
+    {
+        std::vector<std::string> merged;
+        for (int lo = 0; lo < (int)runs.size(); lo += MAX_FAN_IN)
+        {
+            int hi = std::min<int>(runs.size(), lo + MAX_FAN_IN);
+            if (hi - lo == 1)
+            {
+                merged.push_back(runs[lo]);
+                continue;
+            }
+            std::string path = runPath(next_id++);
+            FILE *file = fopen(path.c_str(), "wb");
+            if (file == nullptr)
+                fail(2, "cannot create ", path.c_str());
+            merge(runs, lo, hi, [&](const Record &record) {
+                if (fwrite(&record, sizeof(Record), 1, file) != 1)
+                    fail(2, "cannot write ", path.c_str());
+            });
+            fclose(file);
+            merged.push_back(path);
+        }
+        runs.swap(merged);
+    }
+}
+
+// the final merge runs in its own thread, the caller appends blocks to the tree
+void load(Tree &tree, const std::vector<std::string> &runs, const std::vector<Record> &only,
+          long long &n_key)
+{
+    Tree::bulk_loader loader(&tree, config.fill_percent);
+    n_key = 0;
+    if (runs.empty())
+    {
+        for (const Record &record : only)
+            loader.append(record.key, record.value);
+        n_key = only.size();
+        loader.finish();
+        return;
+    }
+
+    const size_t block_size = 1 << 14;
+    BlockQueue queue(4);
+    std::thread merger([&]() {
+        std::vector<Record> block;
+        block.reserve(block_size);
+        merge(runs, 0, runs.size(), [&](const Record &record) {
+            block.push_back(record);
+            if (block.size() == block_size)
+            {
+                queue.push(block);
+                block.reserve(block_size);
+            }
+        });
+        if (!block.empty())
+            queue.push(block);
+        queue.push(block); // empty
+    });
+    std::vector<Record> block;
+    while (true)
+    {
+        queue.pop(block);
+        if (block.empty())
+            break;
+        for (const Record &record : block)
+            loader.append(record.key, record.value);
+        n_key += block.size();
+    }
+    merger.join();
+    loader.finish();
+}
+// <<<<< pipeline
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+            config.memory = atoll(argv[++i]) << 20;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            config.n_thread = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            config.tmp_dir = argv[++i];
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            config.fill_percent = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            config.file_path = argv[++i];
+        else
+            config.input_path = argv[i];
+    }
+    if (config.memory <= 0)
+        fail(1, "bad memory limit");
+
+    FILE *input = stdin;
+    if (config.input_path != nullptr && (input = fopen(config.input_path, "r")) == nullptr)
+        fail(2, "cannot open ", config.input_path);
+
+    auto start = std::chrono::steady_clock::now();
+    // the reader, the pending run and every worker hold one run,
+    //  stable_sort needs another half
+    size_t capacity = std::max<long long>(1024, config.memory / (config.n_thread + 2) * 2 / 3 /
+                                                    (long long)sizeof(Record));
+    std::vector<Record> only;
+    std::vector<std::string> runs;
+    {
+        Scanner scanner(input);
+        runs = generateRuns(scanner, capacity, only);
+    }
+    if (input != stdin)
+        fclose(input);
+    int n_run = runs.empty() ? 1 : runs.size();
+    reduceRuns(runs);
+    auto sorted = std::chrono::steady_clock::now();
+
+    long long n_key;
+    try
+    {
+        Tree tree(config.file_path);
+        load(tree, runs, only, n_key);
+    }
+    catch (sjtu::runtime_error &)
+    {
+        fail(2, "cannot build ", config.file_path);
+    }
+    auto end = std::chrono::steady_clock::now();
+    fprintf(stderr, "built %s: %lld keys from %d runs, sort %.2fs, total %.2fs\n",
+            config.file_path, n_key, n_run,
+            std::chrono::duration<double>(sorted - start).count(),
+            std::chrono::duration<double>(end - start).count());
+    return 0;
+}
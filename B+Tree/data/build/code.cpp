@@ -0,0 +1,78 @@
+// build.cpp against BTree::insert: the same "i key value" lines with duplicates
+//  and 'q' lines, built by build.cpp and inserted one by one,
+//  must give trees of the same records, for one run, many runs and
+//  more runs than MAX_FAN_IN, which are merged in passes
+//  g++ -O2 -std=c++14 -pthread -I../.. code.cpp
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#define main buildMain
+#include "build.cpp"
+#undef main
+
+using namespace std;
+
+const char *INPUT_PATH = "build_input.txt";
+const char *BUILT_PATH = "build_data.bin";
+const char *INSERTED_PATH = "build_inserted.bin";
+
+// n_line lines of keys in [-n_key / 2, n_key / 2), about a tenth of them 'q'
+void makeInput(int n_line, int n_key, unsigned seed) {
+    mt19937 rng(seed);
+    remove(INSERTED_PATH);
+    Tree tree(INSERTED_PATH);
+    FILE *out = fopen(INPUT_PATH, "w");
+    for (int i = 0; i < n_line; ++i) {
+        int key = (int)(rng() % n_key) - n_key / 2, value = rng() % 2000000000 - 1000000000;
+        if (rng() % 10 == 0) {
+            fprintf(out, "q %d\n", key);
+        } else {
+            fprintf(out, "i %d %d\n", key, value);
+            tree.insert(key, value);
+        }
+    }
+    fclose(out);
+}
+
+void run(int n_line, int n_key, const char *memory_mb, const char *n_thread, const char *fill_percent) {
+    cout << "lines " << n_line << ", keys " << n_key << ", -m " << memory_mb << " -j " << n_thread
+         << " -p " << fill_percent << ": ";
+    makeInput(n_line, n_key, n_line);
+    remove(BUILT_PATH);
+    const char *argv[] = {"build", "-m", memory_mb, "-j", n_thread, "-p", fill_percent,
+                          "-o", BUILT_PATH, INPUT_PATH};
+    if (buildMain(10, (char **)argv) != 0) {
+        cout << "build failed" << endl;
+        return;
+    }
+    Tree built(BUILT_PATH, sjtu::ReadOnly), inserted(INSERTED_PATH, sjtu::ReadOnly);
+    if (built.check().error() != 0) {
+        cout << "errors in built tree" << endl;
+        return;
+    }
+    long long n = 0;
+    auto it = built.seekBegin(), jt = inserted.seekBegin();
+    for (; it.valid() && jt.valid(); ++it, ++jt, ++n)
+        if (it.getKey() != jt.getKey() || it.getValue() != jt.getValue()) {
+            cout << "wrong record " << n << endl;
+            return;
+        }
+    if (it.valid() || jt.valid()) {
+        cout << "wrong size" << endl;
+        return;
+    }
+    cout << "same " << n << " keys, height " << built.analyze().height << endl;
+}
+
+int main() {
+    // build reports its timing to stderr
+    freopen("/dev/null", "w", stderr);
+    run(1000, 500, "1", "1", "100");
+    // 1323 records per run for 64 threads, more than MAX_FAN_IN runs
+    run(600000, 1000000, "1", "64", "100");
+    run(600000, 100000, "1", "2", "70");
+    run(300000, 2000000000, "64", "4", "50");
+    remove(INPUT_PATH), remove(BUILT_PATH), remove(INSERTED_PATH);
+    return 0;
+}
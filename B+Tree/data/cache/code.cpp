@@ -0,0 +1,113 @@
+// HotCache: random insert / modify / erase / at on skewed keys,
+//  at() of a tree with setCache() against a tree without and std::map,
+//  for int, FixedString and a struct key with padding
+//  g++ -O2 -std=c++14 -I../.. code.cpp
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include "BTree.hpp"
+
+using namespace std;
+
+const char *FILE_PATH = "cache_data.bin";
+const char *PLAIN_PATH = "cache_plain.bin";
+
+mt19937 rng(2023), garbage(1);
+
+// a key with 7 bytes of padding after tag, which are garbage,
+//  so that equal keys differ in their bytes
+struct Padded {
+    char tag;
+    long long id;
+
+    Padded() { memset((void *)this, garbage() & 0xff, sizeof(Padded)), tag = 0, id = 0; }
+    Padded(int x) { memset((void *)this, garbage() & 0xff, sizeof(Padded)), tag = 'a' + x % 3, id = x / 3; }
+    Padded(const Padded &other) { memset((void *)this, garbage() & 0xff, sizeof(Padded)), tag = other.tag, id = other.id; }
+    Padded &operator=(const Padded &other) {
+        tag = other.tag, id = other.id;
+        return *this;
+    }
+
+    unsigned long long hash(unsigned long long h) const {
+        return sjtu::hashKey(id, sjtu::hashKey(tag, h));
+    }
+
+    bool operator<(const Padded &rhs) const { return tag < rhs.tag || (tag == rhs.tag && id < rhs.id); }
+    bool operator>(const Padded &rhs) const { return rhs < *this; }
+    bool operator==(const Padded &rhs) const { return tag == rhs.tag && id == rhs.id; }
+    bool operator!=(const Padded &rhs) const { return !(*this == rhs); }
+};
+
+int makeInt(int x) { return x * 7 - 50000; }
+sjtu::FixedString<16> makeString(int x) { return sjtu::FixedString<16>(("k" + to_string(x)).c_str()); }
+Padded makePadded(int x) { return Padded(x); }
+
+// 80% of ops on the first tenth of keys
+//  compact_every: 0 for never, with lazy merge otherwise
+template <class Key, class Make>
+void run(const char *name, int n_op, int n_key, int cache_size, int compact_every, Make make) {
+    typedef sjtu::BTree<Key, long long> Tree;
+    cout << name << ", keys " << n_key << ", cache " << cache_size
+         << (compact_every > 0 ? " lazy" : "") << ": ";
+    remove(FILE_PATH), remove(PLAIN_PATH);
+    map<int, long long> expected;
+    {
+        Tree tree(FILE_PATH), plain(PLAIN_PATH);
+        tree.setCache(cache_size);
+        tree.setLazyMerge(compact_every > 0);
+        for (int i = 0; i < n_op; ++i) {
+            int x = rng() % 10 < 8 ? rng() % (n_key / 10) : rng() % n_key, op = rng() % 10;
+            long long value = (long long)rng() << 20 | i;
+            Key key = make(x);
+            auto it = expected.find(x);
+            bool is_ok = true;
+            if (op < 2) {
+                is_ok = tree.insert(key, value) == (it == expected.end());
+                plain.insert(key, value);
+                expected.emplace(x, value);
+            } else if (op < 4) {
+                is_ok = tree.modify(key, value) == (it != expected.end());
+                plain.modify(key, value);
+                if (it != expected.end())
+                    it->second = value;
+            } else if (op < 5) {
+                is_ok = tree.erase(key) == (it != expected.end());
+                plain.erase(key);
+                if (it != expected.end())
+                    expected.erase(it);
+            } else {
+                long long result = tree.at(key);
+                is_ok = result == plain.at(key) &&
+                        result == (it == expected.end() ? 0 : it->second);
+            }
+            if (compact_every > 0 && (i + 1) % compact_every == 0)
+                tree.compact();
+            if (!is_ok) {
+                cout << "wrong at op " << i << endl;
+                return;
+            }
+        }
+        for (int x = 0; x < n_key; ++x) {
+            auto it = expected.find(x);
+            if (tree.at(make(x)) != (it == expected.end() ? 0 : it->second)) {
+                cout << "wrong key " << x << endl;
+                return;
+            }
+        }
+        cout << "ok " << expected.size() << (tree.stats().cache_hit > 0 ? ", hit" : ", no hit") << endl;
+    }
+    remove(FILE_PATH), remove(PLAIN_PATH);
+}
+
+int main() {
+    run<int>("int", 200000, 20000, 1024, 0, makeInt);
+    run<int>("int", 200000, 20000, 16, 0, makeInt);
+    run<int>("int", 100000, 5000, 1 << 16, 7000, makeInt);
+    run<sjtu::FixedString<16>>("FixedString<16>", 100000, 20000, 1024, 0, makeString);
+    run<Padded>("Padded", 100000, 20000, 1024, 0, makePadded);
+    run<Padded>("Padded", 100000, 5000, 256, 7000, makePadded);
+    return 0;
+}
@@ -0,0 +1,57 @@
+import filecmp
+import os
+import random
+
+# the fast driver of one/BTree.cpp, from a file and from a pipe,
+#  must print the same as the reference driver run with --iostream
+# NOTE: one, two and three share the same BTree.cpp
+
+for name in ['two', 'three']:
+    if not filecmp.cmp('../one/BTree.cpp', '../%s/BTree.cpp' % name, shallow=False):
+        print('[Wrong Answer] BTree.cpp of one and %s differ' % name)
+        exit(-1)
+
+# the BTree.hpp next to BTree.cpp is a stub, so the driver is compiled here
+returnID = os.system(
+    'cp ../one/BTree.cpp driver.cpp && '
+    'g++ -o driver driver.cpp -I../.. -O2 -std=c++14 && rm driver.cpp')
+if returnID != 0:
+    print('Fail to make the driver!')
+    exit(-1)
+
+# inserts, erases and queries of keys with duplicates and negatives,
+#  runs of queries longer than a batch of the fast driver, and a bad command
+random.seed(37)
+with open('driver.data', 'w') as f:
+    for i in range(300000):
+        key = random.randint(-50000, 50000)
+        op = random.randint(0, 9)
+        if op < 4:
+            f.write('i %d %d\n' % (key, random.randint(-2**31, 2**31 - 1)))
+        elif op < 6:
+            f.write('e %d\n' % key)
+        else:
+            f.write('q %d\n' % key)
+        if i == 150000:
+            f.write('x\n')
+        if i % 50000 == 0:
+            for j in range(5000):
+                f.write('q %d\n' % random.randint(-50000, 50000))
+
+runs = [('iostream', './driver --iostream < driver.data'),
+        ('file', './driver < driver.data'),
+        ('pipe', 'cat driver.data | ./driver')]
+for name, command in runs:
+    returnID = os.system('rm -f tree_data.bin && %s > driver_%s.out' % (command, name))
+    if returnID != 0:
+        print('[Runtime Error] %s' % name)
+        exit(-1)
+
+for name, command in runs[1:]:
+    if not filecmp.cmp('driver_iostream.out', 'driver_%s.out' % name, shallow=False):
+        print('[Wrong Answer] %s differs from iostream' % name)
+        exit(-1)
+with open('driver_iostream.out') as f:
+    n_line = sum(1 for line in f)
+os.system('rm -f driver driver.data driver_*.out tree_data.bin')
+print('[Accepted] %d lines, the same for iostream, file and pipe' % n_line)
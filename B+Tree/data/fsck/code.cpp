@@ -0,0 +1,123 @@
+// check() and rebuild(), as fsck runs them: a tree is damaged on disk,
+//  check() of the ReadOnly file must report it,
+//  and the tree rebuilt from the leaf chain must be clean and hold only right records
+//  g++ -O2 -std=c++14 -I../.. code.cpp
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <random>
+#include <unistd.h>
+#include "BTree.hpp"
+
+using namespace std;
+
+typedef sjtu::BTree<int, long long> Tree;
+
+const char *FILE_PATH = "fsck_data.bin";
+const char *NEW_PATH = "fsck_data.bin.new";
+const int BLOCK_SIZE = 4096;
+// prev_offset, succ_offset, node_type and n_key, then PageModel and keys,
+//  and the values of a leaf after MAX_L + 1 = 333 keys
+const int SUCC_OFFSET = 4, TYPE_OFFSET = 8, KEY_OFFSET = 28, VALUE_OFFSET = KEY_OFFSET + 333 * 4;
+const int INTERNAL = 0, LEAF = 1;
+
+mt19937 rng(34);
+map<int, long long> expected;
+
+void build(int n_key) {
+    remove(FILE_PATH);
+    Tree tree(FILE_PATH);
+    while ((int)expected.size() < n_key) {
+        int key = rng() % 100000000;
+        if (expected.emplace(key, (long long)key * 3).second)
+            tree.insert(key, (long long)key * 3);
+    }
+}
+
+// offset of the index-th page of type in file order, 0 if none
+int findPage(int fd, int type, int index) {
+    int header[1];
+    pread(fd, header, sizeof(header), 0);
+    for (int offset = BLOCK_SIZE; offset <= header[0]; offset += BLOCK_SIZE) {
+        int t;
+        pread(fd, &t, sizeof(t), offset + TYPE_OFFSET);
+        if (t == type && index-- == 0)
+            return offset;
+    }
+    return 0;
+}
+
+// swap two items of size bytes at position
+void swapAt(int fd, int position, int size) {
+    char a[8], b[8];
+    pread(fd, a, size, position), pread(fd, b, size, position + size);
+    pwrite(fd, b, size, position), pwrite(fd, a, size, position + size);
+}
+
+// damage: 0 garbage over the root, 1 garbage over a leaf,
+//  2 two records of a leaf swapped, 3 a broken succ_offset
+void damage(int mode) {
+    int fd = open(FILE_PATH, O_RDWR);
+    if (mode == 0 || mode == 1) {
+        // the root is the only internal page of 100000 keys
+        int offset = findPage(fd, mode == 0 ? INTERNAL : LEAF, mode == 0 ? 0 : 3);
+        char garbage[BLOCK_SIZE];
+        for (int i = 0; i < BLOCK_SIZE; ++i)
+            garbage[i] = rng() & 0xff;
+        pwrite(fd, garbage, BLOCK_SIZE, offset);
+    } else if (mode == 2) {
+        int offset = findPage(fd, LEAF, 10);
+        swapAt(fd, offset + KEY_OFFSET + 5 * sizeof(int), sizeof(int));
+        swapAt(fd, offset + VALUE_OFFSET + 5 * sizeof(long long), sizeof(long long));
+    } else {
+        int offset = findPage(fd, LEAF, 20), succ = BLOCK_SIZE / 2;
+        pwrite(fd, &succ, sizeof(succ), offset + SUCC_OFFSET);
+    }
+    close(fd);
+}
+
+// every record of the rebuilt tree is in expected, in order
+void verify(long long n_rebuilt) {
+    Tree tree(NEW_PATH, sjtu::ReadOnly);
+    long long n = 0;
+    bool is_ok = tree.check().error() == 0;
+    int last = -1;
+    for (auto it = tree.seekBegin(); it.valid(); ++it, ++n) {
+        auto jt = expected.find(it.getKey());
+        if (jt == expected.end() || jt->second != it.getValue() || it.getKey() <= last)
+            is_ok = false;
+        last = it.getKey();
+    }
+    cout << "rebuilt " << n_rebuilt << " of " << expected.size() << " keys, "
+         << (is_ok && n == n_rebuilt ? "clean" : "wrong") << endl;
+}
+
+void run(const char *name, int mode) {
+    cout << name << ": ";
+    damage(mode);
+    Tree tree(FILE_PATH, sjtu::ReadOnly);
+    sjtu::Check result = tree.check();
+    cout << (result.error() > 0 ? "detected" : "not detected") << " (bad page " << result.bad_page
+         << ", order " << result.bad_order << ", chain " << result.bad_chain << "), ";
+    remove(NEW_PATH);
+    verify(tree.rebuild(NEW_PATH));
+    remove(NEW_PATH);
+}
+
+int main() {
+    const char *NAMES[] = {"root garbage", "leaf garbage", "records swapped", "chain broken"};
+    for (int mode = 0; mode < 4; ++mode) {
+        expected.clear();
+        build(100000);
+        {
+            Tree tree(FILE_PATH, sjtu::ReadOnly);
+            if (tree.check().error() != 0)
+                cout << "errors before damage" << endl;
+        }
+        run(NAMES[mode], mode);
+    }
+    remove(FILE_PATH);
+    return 0;
+}
@@ -0,0 +1,90 @@
+// lazy merge: random insert / erase / lower_bound / at against std::map,
+//  with compact() and switches between lazy and eager merge in between
+//  g++ -O2 -std=c++14 -I../.. code.cpp
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include "BTree.hpp"
+
+using namespace std;
+
+const char *FILE_PATH = "lazy_data.bin";
+
+// a large key, so that leaves are small and merges are frequent
+struct Big {
+    int v;
+    char pad[396];
+
+    Big() : v(0) {}
+    Big(int v) : v(v) {}
+    bool operator>(const Big &other) const { return v > other.v; }
+    bool operator==(const Big &other) const { return v == other.v; }
+    bool operator!=(const Big &other) const { return v != other.v; }
+};
+
+// compact_every, flip_every: 0 for never
+template <class Key>
+void run(const char *name, int n_op, int n_key, unsigned seed, int compact_every, int flip_every) {
+    cout << name << ": ";
+    remove(FILE_PATH);
+    map<int, int> expected;
+    mt19937 rng(seed);
+    sjtu::BTree<Key, int> tree(FILE_PATH);
+    bool is_lazy = true;
+    tree.setLazyMerge(is_lazy);
+    for (int i = 0; i < n_op; ++i) {
+        if (compact_every > 0 && i % compact_every == compact_every - 1)
+            tree.compact(rng() % 100 + 1);
+        if (flip_every > 0 && i % flip_every == 0)
+            tree.setLazyMerge(is_lazy = !is_lazy);
+        int op = rng() % 10, key = rng() % n_key, value = rng() % 1000000;
+        bool is_ok = true;
+        if (op < 4)
+            is_ok = tree.insert(key, value) == expected.insert(make_pair(key, value)).second;
+        else if (op < 8)
+            is_ok = tree.erase(key) == (expected.erase(key) > 0);
+        else if (op < 9) {
+            auto it = expected.lower_bound(key);
+            auto jt = tree.lower_bound(Key(key));
+            is_ok = (it == expected.end()) == (jt == tree.end());
+            if (is_ok && it != expected.end())
+                is_ok = jt.getKey() == Key(it->first) && jt.getValue() == it->second;
+            if (is_ok && it != expected.end() && it != expected.begin())
+                is_ok = (--jt).getKey() == Key((--it)->first);
+        } else {
+            auto it = expected.find(key);
+            is_ok = tree.at(key) == (it == expected.end() ? 0 : it->second);
+        }
+        if (!is_ok) {
+            cout << "wrong at op " << i << endl;
+            return;
+        }
+    }
+    auto jt = tree.begin();
+    for (auto &p : expected) {
+        if (jt == tree.end() || jt.getKey() != Key(p.first) || jt.getValue() != p.second) {
+            cout << "wrong scan" << endl;
+            return;
+        }
+        ++jt;
+    }
+    if (jt != tree.end()) {
+        cout << "wrong scan" << endl;
+        return;
+    }
+    cout << "ok " << expected.size() << endl;
+}
+
+int main() {
+    run<int>("int", 300000, 20000, 1, 0, 0);
+    run<Big>("big", 200000, 5000, 2, 0, 0);
+    run<Big>("big compact", 200000, 5000, 3, 20000, 0);
+    run<Big>("big compact flip", 200000, 3000, 4, 7001, 3000);
+    run<int>("int compact flip", 300000, 50000, 5, 50000, 10000);
+    run<Big>("big tiny", 50000, 100, 6, 999, 777);
+    remove(FILE_PATH);
+    remove((string(FILE_PATH) + ".compact").c_str());
+    return 0;
+}
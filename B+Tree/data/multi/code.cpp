@@ -0,0 +1,72 @@
+// MultiBTree: random insert / erase(key, value) / equal_range against std::set of pairs,
+//  for several POSTING_SIZE, then every key after reopening the file
+//  g++ -O2 -std=c++14 -I../.. code.cpp
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <set>
+#include "BTree.hpp"
+
+using namespace std;
+
+const char *FILE_PATH = "multi_data.bin";
+
+// the values of key in tree are exactly those in expected
+template <class Tree>
+bool isSame(Tree &tree, const set<pair<int, int>> &expected, int key) {
+    auto it = expected.lower_bound(make_pair(key, INT_MIN));
+    auto jt = tree.equal_range(key);
+    for (; it != expected.end() && it->first == key; ++it, ++jt)
+        if (!jt.valid() || jt.getValue() != it->second)
+            return false;
+    return !jt.valid();
+}
+
+// n_key keys with n_value values each, so that one key spans many posting lists
+template <int POSTING_SIZE>
+void run(int n_op, int n_key, int n_value, unsigned seed, bool is_lazy) {
+    typedef sjtu::MultiBTree<int, int, POSTING_SIZE> Tree;
+    cout << "posting " << POSTING_SIZE << ", keys " << n_key << ", values " << n_value
+         << (is_lazy ? " lazy" : "") << ": ";
+    remove(FILE_PATH);
+    mt19937 rng(seed);
+    set<pair<int, int>> expected;
+    {
+        Tree tree(FILE_PATH);
+        tree.setLazyMerge(is_lazy);
+        for (int i = 0; i < n_op; ++i) {
+            int key = rng() % n_key, value = rng() % n_value, op = rng() % 10;
+            bool is_ok;
+            if (op < 5)
+                is_ok = tree.insert(key, value) == expected.insert(make_pair(key, value)).second;
+            else if (op < 8)
+                is_ok = tree.erase(key, value) == (expected.erase(make_pair(key, value)) > 0);
+            else
+                is_ok = isSame(tree, expected, key);
+            if (!is_ok) {
+                cout << "wrong at op " << i << endl;
+                return;
+            }
+        }
+    }
+    Tree tree(FILE_PATH);
+    for (int key = -1; key <= n_key; ++key)
+        if (!isSame(tree, expected, key)) {
+            cout << "wrong key " << key << " after reopening" << endl;
+            return;
+        }
+    cout << "ok " << expected.size() << endl;
+}
+
+int main() {
+    for (unsigned seed = 1; seed <= 2; ++seed) {
+        run<1>(60000, 50, 5000, seed, false);
+        run<4>(60000, 50, 5000, seed, false);
+        run<16>(60000, 5, 100000, seed, false);
+        run<64>(40000, 3, 100000, seed, false);
+        run<16>(60000, 20, 2000, seed, true);
+    }
+    remove(FILE_PATH);
+    return 0;
+}
@@ -0,0 +1,158 @@
+// PackedLeaf: random insert / erase / modify / at / seek against std::map,
+//  with small, wide, full 64-bit and negative values, then the bulk loader
+//  g++ -O2 -std=c++14 -I../.. code.cpp (-mavx2 for the gather decoder)
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include "BTree.hpp"
+
+using namespace std;
+
+typedef sjtu::BTree<int, long long, sjtu::BinarySearch, sjtu::PackedLeaf> Tree;
+
+const char *FILE_PATH = "packed_data.bin";
+const char *MODE_NAMES[] = {"small", "wide", "full", "negative"};
+
+// mode 0: small values, 1: wide values, 2: full 64-bit values, 3: small negative values
+long long randomValue(mt19937_64 &rng, int mode) {
+    if (mode == 0)
+        return rng() % 1000;
+    if (mode == 1)
+        return (long long)(rng() % 2000000000) - 1000000000;
+    if (mode == 2)
+        return (long long)rng();
+    return -(long long)(rng() % 100);
+}
+
+// keys are (0, 1, ..., n_key - 1) * key_step, shifted to be centered at 0
+//  compact_every: 0 for never
+void run(int n_op, int n_key, int key_step, unsigned seed, int mode, bool is_lazy, int compact_every) {
+    cout << MODE_NAMES[mode] << " values, keys " << n_key << " * " << key_step
+         << (is_lazy ? " lazy" : "") << ": ";
+    remove(FILE_PATH);
+    map<int, long long> expected;
+    mt19937_64 rng(seed);
+    {
+        Tree tree(FILE_PATH);
+        tree.setLazyMerge(is_lazy);
+        for (int i = 0; i < n_op; ++i) {
+            if (compact_every > 0 && i % compact_every == compact_every - 1)
+                tree.compact(rng() % 100 + 1);
+            int op = rng() % 10;
+            int key = (int)((long long)(rng() % n_key) * key_step - (long long)n_key * key_step / 2);
+            long long value = randomValue(rng, mode);
+            bool is_ok = true;
+            if (op < 5)
+                is_ok = tree.insert(key, value) == expected.insert(make_pair(key, value)).second;
+            else if (op < 8)
+                is_ok = tree.erase(key) == (expected.erase(key) > 0);
+            else if (op < 9) {
+                auto it = expected.find(key);
+                bool is_found = it != expected.end();
+                if (is_found)
+                    it->second = value;
+                is_ok = tree.modify(key, value) == is_found;
+            } else {
+                auto it = expected.find(key);
+                is_ok = tree.at(key) == (it == expected.end() ? 0 : it->second);
+                // a cursor decodes whole leaves
+                it = expected.lower_bound(key);
+                Tree::cursor jt = tree.seek(key);
+                for (int j = 0; is_ok && j < 20 && it != expected.end(); ++j, ++it, ++jt)
+                    is_ok = jt.valid() && jt.getKey() == it->first && jt.getValue() == it->second;
+            }
+            if (!is_ok) {
+                cout << "wrong at op " << i << endl;
+                return;
+            }
+        }
+    }
+    Tree tree(FILE_PATH);
+    auto jt = tree.begin();
+    for (auto &p : expected) {
+        if (jt == tree.end() || jt.getKey() != p.first || jt.getValue() != p.second) {
+            cout << "wrong scan" << endl;
+            return;
+        }
+        ++jt;
+    }
+    if (jt != tree.end()) {
+        cout << "wrong scan" << endl;
+        return;
+    }
+    sjtu::Analysis analysis = tree.analyze();
+    cout << "ok " << expected.size() << ", height " << analysis.height
+         << ", leaves " << analysis.n_node[analysis.height - 1] << endl;
+}
+
+void TestRandom() {
+    for (int mode = 0; mode < 4; ++mode) {
+        run(150000, 50000, 1, mode + 1, mode, false, 0);
+        run(150000, 50000, 40000, mode + 11, mode, false, 0);
+        run(100000, 3000, 1, mode + 21, mode, false, 0);
+        run(100000, 30000, 7, mode + 31, mode, true, 40000);
+    }
+}
+
+// a bulk-loaded leaf keeps the longest prefix that fits
+void TestBulkLoad() {
+    for (int mode = 0; mode < 4; ++mode) {
+        cout << "bulk load " << MODE_NAMES[mode] << ": ";
+        remove(FILE_PATH);
+        mt19937_64 rng(mode);
+        map<int, long long> expected;
+        for (int i = 0; i < 200000; ++i)
+            expected[(int)(rng() % 100000000)] = randomValue(rng, mode);
+        Tree tree(FILE_PATH);
+        {
+            Tree::bulk_loader loader(&tree, 100);
+            for (auto &p : expected)
+                loader.append(p.first, p.second);
+            loader.finish();
+        }
+        bool is_ok = true;
+        Tree::cursor jt = tree.seek(-2147483647);
+        for (auto it = expected.begin(); is_ok && it != expected.end(); ++it, ++jt)
+            is_ok = jt.valid() && jt.getKey() == it->first && jt.getValue() == it->second;
+        for (int i = 0; is_ok && i < 2000; ++i) {
+            auto it = expected.lower_bound((int)(rng() % 100000000));
+            is_ok = it == expected.end() || tree.at(it->first) == it->second;
+        }
+        cout << (is_ok ? "ok" : "wrong") << endl;
+    }
+}
+
+// modify() by a wider value splits a full packed leaf, instead of failing to save it
+void TestWiden() {
+    for (int by_iterator = 0; by_iterator < 2; ++by_iterator) {
+        cout << "widen" << (by_iterator ? " by iterator" : "") << ": ";
+        remove(FILE_PATH);
+        Tree tree(FILE_PATH);
+        const int N = 650;
+        for (int i = 0; i < N; ++i)
+            tree.insert(i, 0);
+        bool is_ok = true;
+        for (int i = 0; is_ok && i < N; ++i) {
+            long long value = (long long)i << 50;
+            if (by_iterator)
+                is_ok = tree.find(i).modify(value);
+            else
+                is_ok = tree.modify(i, value);
+        }
+        for (int i = 0; is_ok && i < N; ++i)
+            is_ok = tree.at(i) == (long long)i << 50;
+        sjtu::Analysis analysis = tree.analyze();
+        cout << (is_ok ? "ok" : "wrong") << ", leaves " << analysis.n_node[analysis.height - 1] << endl;
+    }
+}
+
+int main() {
+    TestRandom();
+    TestBulkLoad();
+    TestWiden();
+    remove(FILE_PATH);
+    remove((string(FILE_PATH) + ".compact").c_str());
+    return 0;
+}
@@ -0,0 +1,115 @@
+// FixedString keys: prefix_scan against std::map for several prefixes,
+//  and the error of estimate_range on random ranges,
+//  for a bulk-loaded tree and for a tree of random inserts and erases
+//  g++ -O2 -std=c++14 -I../.. code.cpp
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "BTree.hpp"
+
+using namespace std;
+
+typedef sjtu::FixedString<16> Str;
+typedef sjtu::BTree<Str, int> Tree;
+
+const char *FILE_PATH = "prefix_data.bin";
+const char *PREFIXES[] = {"", "a", "f", "abc", "fed", "abcdef", "ffffff", "zz", "aaaaaaaaaaaaaaaa"};
+
+// 3 to 12 letters of a to f
+string randomString(mt19937 &rng) {
+    int len = 3 + rng() % 10;
+    string s;
+    for (int i = 0; i < len; ++i)
+        s += (char)('a' + rng() % 6);
+    return s;
+}
+
+// prefix_scan finds exactly the keys of expected starting with prefix, in order
+bool checkPrefix(Tree &tree, const map<string, int> &expected, const char *prefix) {
+    int len = strlen(prefix);
+    auto it = expected.lower_bound(prefix);
+    bool is_ok = true;
+    long long n = tree.prefix_scan(prefix, [&](const Str &key, int value) {
+        if (it == expected.end() || it->first.compare(0, len, prefix) != 0 ||
+            !(key == Str(it->first.c_str())) || value != it->second)
+            is_ok = false;
+        else
+            ++it;
+    });
+    if (it != expected.end() && it->first.compare(0, len, prefix) == 0)
+        is_ok = false;
+    cout << "  \"" << prefix << "\": " << n << (is_ok ? " ok" : " wrong") << endl;
+    return is_ok;
+}
+
+// mean relative error of estimate_range over ranges of at least 1000 keys is within bound
+void checkEstimate(Tree &tree, const map<string, int> &expected, mt19937 &rng, double bound) {
+    double sum = 0;
+    int n_range = 0;
+    while (n_range < 200) {
+        string lo = randomString(rng), hi = randomString(rng);
+        if (hi < lo)
+            swap(lo, hi);
+        long long n = distance(expected.lower_bound(lo), expected.upper_bound(hi));
+        if (n < 1000)
+            continue;
+        long long m = tree.estimate_range(Str(lo.c_str()), Str(hi.c_str()));
+        sum += fabs((double)(m - n)) / n;
+        n_range++;
+    }
+    cout << "  estimate: " << (sum / n_range <= bound ? "ok" : "too far") << endl;
+    cout << "  empty range: " << tree.estimate_range(Str("f"), Str("a")) << endl;
+}
+
+void run(int n_key, unsigned seed, bool is_bulk, double bound) {
+    cout << (is_bulk ? "bulk loaded" : "random inserts") << ", keys " << n_key << ":" << endl;
+    remove(FILE_PATH);
+    mt19937 rng(seed);
+    map<string, int> expected;
+    while ((int)expected.size() < n_key)
+        expected.emplace(randomString(rng), rng() % 1000000);
+    {
+        Tree tree(FILE_PATH);
+        if (is_bulk) {
+            Tree::bulk_loader loader(&tree);
+            for (auto &p : expected)
+                loader.append(Str(p.first.c_str()), p.second);
+            loader.finish();
+        } else {
+            vector<pair<string, int>> order(expected.begin(), expected.end());
+            shuffle(order.begin(), order.end(), rng);
+            for (auto &p : order)
+                tree.insert(Str(p.first.c_str()), p.second);
+            // erase about 10% of keys
+            for (auto it = expected.begin(); it != expected.end();)
+                if (rng() % 10 == 0) {
+                    tree.erase(Str(it->first.c_str()));
+                    it = expected.erase(it);
+                } else {
+                    ++it;
+                }
+        }
+    }
+    Tree tree(FILE_PATH);
+    for (const char *prefix : PREFIXES)
+        checkPrefix(tree, expected, prefix);
+    for (int i = 0; i < 3; ++i) {
+        string prefix = randomString(rng).substr(0, 2 + i);
+        checkPrefix(tree, expected, prefix.c_str());
+    }
+    checkEstimate(tree, expected, rng, bound);
+}
+
+int main() {
+    run(300000, 1, true, 0.1);
+    run(300000, 2, false, 0.25);
+    remove(FILE_PATH);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// search policies: random insert / erase / modify / at / lower_bound against std::map,
+//  on uniform, clustered and skewed key sets, then a scan after reopening the file
+//  g++ -O2 -std=c++14 -I../.. code.cpp
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "BTree.hpp"
+
+using namespace std;
+
+const char *FILE_PATH = "search_data.bin";
+
+// n increasing keys, negative ones included
+//  uniform: evenly spaced
+//  clustered: runs of 64 adjacent keys, separated by random gaps
+//  skewed: mostly adjacent, with a random jump at one key of 8
+vector<int> keySet(int n, const string &distribution, mt19937 &rng) {
+    vector<int> keys(n);
+    int key = -n;
+    for (int i = 0; i < n; ++i) {
+        keys[i] = key;
+        if (distribution == "uniform")
+            key += 3;
+        else if (distribution == "clustered")
+            key += i % 64 == 63 ? 1 + rng() % 100000 : 1;
+        else
+            key += rng() % 8 == 0 ? 1 + rng() % 100000 : 1;
+    }
+    return keys;
+}
+
+template <class Search>
+void run(const char *name, const string &distribution, int n_op, int n_key, unsigned seed) {
+    cout << name << ' ' << distribution << ": ";
+    remove(FILE_PATH);
+    mt19937 rng(seed);
+    vector<int> keys = keySet(n_key, distribution, rng);
+    map<int, long long> expected;
+    {
+        sjtu::BTree<int, long long, Search> tree(FILE_PATH);
+        for (int i = 0; i < n_op; ++i) {
+            int op = rng() % 10, key = keys[rng() % n_key];
+            long long value = rng();
+            bool is_ok = true;
+            if (op < 5)
+                is_ok = tree.insert(key, value) == expected.insert(make_pair(key, value)).second;
+            else if (op < 7)
+                is_ok = tree.erase(key) == (expected.erase(key) > 0);
+            else if (op < 8) {
+                auto it = expected.find(key);
+                bool is_found = it != expected.end();
+                if (is_found)
+                    it->second = value;
+                is_ok = tree.modify(key, value) == is_found;
+            } else if (op < 9) {
+                // between two keys as well
+                key -= rng() % 2;
+                auto it = expected.lower_bound(key);
+                auto jt = tree.lower_bound(key);
+                is_ok = (it == expected.end()) == (jt == tree.end());
+                if (is_ok && it != expected.end())
+                    is_ok = jt.getKey() == it->first && jt.getValue() == it->second;
+            } else {
+                auto it = expected.find(key);
+                is_ok = tree.at(key) == (it == expected.end() ? 0 : it->second);
+            }
+            if (!is_ok) {
+                cout << "wrong at op " << i << endl;
+                return;
+            }
+        }
+    }
+    sjtu::BTree<int, long long, Search> tree(FILE_PATH);
+    auto jt = tree.begin();
+    for (auto &p : expected) {
+        if (jt == tree.end() || jt.getKey() != p.first || jt.getValue() != p.second) {
+            cout << "wrong scan" << endl;
+            return;
+        }
+        ++jt;
+    }
+    if (jt != tree.end()) {
+        cout << "wrong scan" << endl;
+        return;
+    }
+    cout << "ok " << expected.size() << endl;
+}
+
+template <class Search>
+void TestSearch(const char *name) {
+    const char *distributions[] = {"uniform", "clustered", "skewed"};
+    for (int i = 0; i < 3; ++i)
+        run<Search>(name, distributions[i], 200000, 30000, i + 1);
+}
+
+int main() {
+    TestSearch<sjtu::LinearSearch>("linear");
+    TestSearch<sjtu::BinarySearch>("binary");
+    TestSearch<sjtu::InterpolationSearch>("interpolation");
+    TestSearch<sjtu::LearnedSearch>("learned");
+    remove(FILE_PATH);
+    return 0;
+}
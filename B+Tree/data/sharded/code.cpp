@@ -0,0 +1,120 @@
+// ShardedBTree: results of a clean run, and a writer thread whose BTree operation throws
+//  g++ -O2 -std=c++14 -pthread -I../.. code.cpp
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ShardedBTree.hpp"
+
+using namespace std;
+
+const int N_SHARD = 2;
+const char *PREFIX = "sharded_data.bin";
+
+// comparing the poisoned key throws something other than sjtu::runtime_error
+atomic<int> poison(-1);
+
+struct Key {
+    int v;
+
+    Key() : v(0) {}
+    Key(int v) : v(v) {}
+    bool operator>(const Key &other) const {
+        if (v == poison || other.v == poison)
+            throw logic_error("poisoned key");
+        return v > other.v;
+    }
+    bool operator==(const Key &other) const { return v == other.v; }
+    bool operator!=(const Key &other) const { return v != other.v; }
+};
+
+struct Hash {
+    size_t operator()(const Key &key) const { return key.v; }
+};
+
+typedef sjtu::ShardedBTree<Key, int, Hash> Tree;
+
+void clean() {
+    for (int i = 0; i < N_SHARD; ++i)
+        remove((string(PREFIX) + "." + to_string(i)).c_str());
+}
+
+void TestClean() {
+    cout << "clean:" << endl;
+    clean();
+    Tree tree(PREFIX, N_SHARD);
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(Key(i), i * 3);
+    for (int i = 0; i < 1000; i += 2)
+        tree.erase(Key(i));
+    tree.modify(Key(1), -1);
+    tree.flush();
+    long long sum = 0;
+    for (int i = 0; i < 1000; ++i)
+        sum += tree.at(Key(i));
+    cout << sum << endl;
+    int n = 0;
+    for (Tree::cursor it = tree.seek(Key(990)); it.valid(); ++it, ++n)
+        cout << it.getKey().v << ' ' << it.getValue() << endl;
+    cout << n << endl;
+}
+
+void TestFailed() {
+    cout << "failed:" << endl;
+    clean();
+    Tree tree(PREFIX, N_SHARD);
+    for (int i = 0; i < 100; ++i)
+        tree.insert(Key(i), i);
+    tree.flush();
+    // key 150 lives in shard 0, whose writer throws at the first comparison with it
+    poison = 150;
+    for (int i = 100; i < 200; ++i)
+        tree.insert(Key(i), i);
+    for (int k = 0; k < 2; ++k) {
+        try {
+            tree.flush();
+            cout << "flush: ok" << endl;
+        } catch (logic_error &error) {
+            cout << "flush: " << error.what() << endl;
+        }
+    }
+    poison = -1;
+    // shard 1 is healthy, shard 0 keeps failing
+    cout << tree.at(Key(1)) << ' ' << tree.at(Key(199)) << endl;
+    try {
+        cout << tree.at(Key(2)) << endl;
+    } catch (logic_error &error) {
+        cout << "at: " << error.what() << endl;
+    }
+}
+
+// a shard which cannot be opened releases the others
+void TestOpen() {
+    cout << "open:" << endl;
+    clean();
+    string blocked = string(PREFIX) + ".3";
+    mkdir(blocked.c_str(), 0755);
+    try {
+        sjtu::ShardedBTree<int, int> tree(PREFIX, 4);
+        cout << "opened" << endl;
+    } catch (sjtu::runtime_error &) {
+        cout << "refused" << endl;
+    }
+    rmdir(blocked.c_str());
+    sjtu::ShardedBTree<int, int> tree(PREFIX, 4);
+    tree.insert(3, 4);
+    cout << tree.at(3) << endl;
+    for (int i = 0; i < 4; ++i)
+        remove((string(PREFIX) + "." + to_string(i)).c_str());
+}
+
+int main() {
+    TestClean();
+    TestFailed();
+    TestOpen();
+    clean();
+    return 0;
+}
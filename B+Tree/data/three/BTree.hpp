@@ -30,6 +30,12 @@ namespace sjtu {
 
         }
 
+        // values[i] = at(keys[i]), the tester answers runs of queries by it
+        void at(const Key *keys, Value *values, int n) {
+            for (int i = 0; i < n; ++i)
+                values[i] = at(keys[i]);
+        }
+
         bool insert(const Key &key, const Value &value) {
 
         }
@@ -1,6 +1,11 @@
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "BTree.hpp"
   //  test: constructor
 using namespace std;
@@ -19,7 +24,9 @@ int query(int key){
 }
 
 
+// reference driver, run with --iostream
 void tester(){
+  //assert(bTree.begin() == bTree.begin());
   int key, value;
   char cmd;
   while(cin >> cmd){
@@ -40,7 +47,129 @@ void tester(){
   }
 }
 
-int main(){
-  tester();
+// stdin as one mmap if it is a regular file, otherwise read in chunks
+class Reader{
+  static const int CHUNK_SIZE = 1 << 20;
+  char *buffer;
+  size_t pos, len;
+  bool is_mapped;
+
+  int refill(){
+    if(is_mapped) return EOF;
+    ssize_t n = read(0, buffer, CHUNK_SIZE);
+    if(n <= 0) return EOF;
+    pos = 0, len = n;
+    return (unsigned char)buffer[0];
+  }
+
+public:
+  Reader() : pos(0), len(0), is_mapped(false){
+    struct stat file_stat;
+    if(fstat(0, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0){
+      void *data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, 0, 0);
+      if(data != MAP_FAILED){
+        madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+        buffer = (char *)data, len = file_stat.st_size, is_mapped = true;
+        return;
+      }
+    }
+    buffer = new char[CHUNK_SIZE];
+  }
+  ~Reader(){
+    if(is_mapped) munmap(buffer, len);
+    else delete[] buffer;
+  }
+
+  int peek(){
+    return pos < len ? (unsigned char)buffer[pos] : refill();
+  }
+
+  // next non-space char, as cin >> cmd
+  int readChar(){
+    int c = peek();
+    while(c == ' ' || c == '\n' || c == '\r' || c == '\t') pos++, c = peek();
+    if(c != EOF) pos++;
+    return c;
+  }
+
+  int readInt(){
+    int c = readChar();
+    bool is_negative = c == '-';
+    if(is_negative) c = readChar();
+    int x = c - '0';
+    while((c = peek()) >= '0' && c <= '9') x = x * 10 + (c - '0'), pos++;
+    return is_negative ? -x : x;
+  }
+};
+
+class Writer{
+  static const int BUFFER_SIZE = 1 << 16;
+  char buffer[BUFFER_SIZE];
+  int len;
+
+public:
+  Writer() : len(0){}
+  ~Writer(){ flush(); }
+
+  void flush(){
+    fwrite(buffer, 1, len, stdout);
+    fflush(stdout);
+    len = 0;
+  }
+
+  void writeLine(const char *s){
+    if(len + 100 > BUFFER_SIZE) flush();
+    while(*s) buffer[len++] = *s++;
+    buffer[len++] = '\n';
+  }
+
+  void writeInt(int x){
+    if(len + 16 > BUFFER_SIZE) flush();
+    unsigned int u = x;
+    if(x < 0) buffer[len++] = '-', u = -u;
+    char digit[12];
+    int n = 0;
+    do digit[n++] = '0' + u % 10, u /= 10; while(u > 0);
+    while(n > 0) buffer[len++] = digit[--n];
+    buffer[len++] = '\n';
+  }
+};
+
+// consecutive queries are answered by one batch at()
+void fastTester(){
+  const int MAX_BATCH = 4096;
+  static int keys[MAX_BATCH], values[MAX_BATCH];
+  int n_query = 0;
+  Reader reader;
+  Writer writer;
+  auto answer = [&](){
+    bTree.at(keys, values, n_query);
+    for(int i = 0; i < n_query; ++i) writer.writeInt(values[i]);
+    n_query = 0;
+  };
+  int cmd;
+  while((cmd = reader.readChar()) != EOF){
+    if(cmd == 'q'){
+      keys[n_query++] = reader.readInt();
+      if(n_query == MAX_BATCH) answer();
+      continue;
+    }
+    if(n_query > 0) answer();
+    if(cmd == 'i'){
+      int key = reader.readInt();
+      insert(key, reader.readInt());
+    }else
+    if(cmd == 'e'){
+      erase(reader.readInt());
+    }else{
+      writer.writeLine("bad_command");
+    }
+  }
+  if(n_query > 0) answer();
+}
+
+int main(int argc, char **argv){
+  if(argc > 1 && strcmp(argv[1], "--iostream") == 0) tester();
+  else fastTester();
   return 0;
 }
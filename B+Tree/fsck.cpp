@@ -0,0 +1,61 @@
+// offline verifier of a BTree file, see BTree::check()
+//  g++ -O2 -std=c++14 fsck.cpp -o fsck
+//  ./fsck [-r new_file] [-p fill_percent] [file]
+//      -r: rebuild a clean tree in new_file from the leaf chain
+// NOTE: the file is opened ReadOnly, it is never modified
+//  compile with -DKEY=... -DVALUE=... -DLAYOUT=... for other trees
+// returns: 0 if no error is found, 1 if errors are found, 2 if file cannot be opened
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "BTree.hpp"
+
+#ifndef KEY
+#define KEY int
+#endif
+#ifndef VALUE
+#define VALUE long long
+#endif
+#ifndef LAYOUT
+#define LAYOUT PlainLeaf
+#endif
+
+typedef sjtu::BTree<KEY, VALUE, sjtu::LinearSearch, sjtu::LAYOUT> Tree;
+
+int main(int argc, char **argv)
+{
+    const char *file_path = "tree_data.bin";
+    const char *new_path = nullptr;
+    int fill_percent = 100;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            new_path = argv[++i];
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            fill_percent = atoi(argv[++i]);
+        else
+            file_path = argv[i];
+    }
+
+    Tree *tree;
+    try
+    {
+        tree = new Tree(file_path, sjtu::ReadOnly);
+    }
+    catch (sjtu::runtime_error &)
+    {
+        fprintf(stderr, "cannot open %s\n", file_path);
+        return 2;
+    }
+
+    sjtu::Check result = tree->check(stderr);
+    result.print();
+    if (new_path != nullptr)
+    {
+        long long n_key = tree->rebuild(new_path, fill_percent);
+        printf("rebuilt %s: %lld keys, %lld keys reachable from root\n",
+               new_path, n_key, result.n_key);
+    }
+    delete tree;
+    return result.error() > 0 ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "BTree.hpp"
+
+// N reader processes serve lookups from file_path,
+//  while a builder publishes new versions by rename()
+// every version v stores (key, key * v) and (-1, v)
+
+const char *file_path = "share_data.bin";
+const char *tmp_path = "share_data.bin.tmp";
+const int n = 20000;
+const int n_reader = 8;
+const int n_version = 10;
+
+void build(int version)
+{
+    remove(tmp_path);
+    {
+        sjtu::BTree<int, long long> tree(tmp_path);
+        tree.insert(-1, version);
+        for (int i = 0; i < n; ++i)
+            tree.insert(i, (long long)i * version);
+    }
+    rename(tmp_path, file_path);
+}
+
+// returns: exit code
+int serve(int id)
+{
+    sjtu::BTree<int, long long> tree(file_path, sjtu::ReadOnly);
+    int last_version = 0;
+    unsigned seed = id;
+    while (last_version < n_version)
+    {
+        tree.refresh();
+        long long version = tree.at(-1);
+        if (version < last_version)
+        {
+            fprintf(stderr, "reader %d: version goes back\n", id);
+            return 1;
+        }
+        last_version = version;
+        for (int i = 0; i < 100; ++i)
+        {
+            int key = rand_r(&seed) % n;
+            if (tree.at(key) != key * version)
+            {
+                fprintf(stderr, "reader %d: inconsistent version %lld\n", id, version);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main()
+{
+    printf("Test Shared Read.\n");
+    build(1);
+    try
+    {
+        sjtu::BTree<int, long long> tree(file_path, sjtu::ReadOnly);
+        tree.insert(n, n);
+        fprintf(stderr, "ReadOnly tree is modified\n");
+        return 1;
+    }
+    catch (sjtu::runtime_error &)
+    {
+    }
+
+    fflush(stdout);
+    for (int i = 0; i < n_reader; ++i)
+        if (fork() == 0)
+            exit(serve(i));
+
+    for (int version = 2; version <= n_version; ++version)
+        build(version);
+
+    bool is_passed = true;
+    for (int i = 0; i < n_reader; ++i)
+    {
+        int status;
+        wait(&status);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            is_passed = false;
+    }
+    remove(file_path);
+    if (is_passed)
+        printf("Test Shared Read Pass!\n");
+    return is_passed ? 0 : 1;
+}
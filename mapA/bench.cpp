@@ -0,0 +1,112 @@
+// benchmark of sjtu::map against sjtu::btree_map on random int keys
+//  g++ -O2 -std=c++14 bench.cpp -o bench
+//  ./bench [-n keys] [-s seed]
+// phases: insert, find_hit, find_miss, iterate, erase
+//  memory per element is the growth of the heap (mallinfo2) after insert
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <malloc.h>
+#include "map.hpp"
+#include "btree_map.hpp"
+
+struct Config
+{
+    int n = 1000000;
+    unsigned seed = 2020;
+};
+
+Config config;
+std::vector<int> keys, misses;
+
+size_t heapSize()
+{
+    return mallinfo2().uordblks;
+}
+
+template <class F>
+double measure(F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char *name, const char *phase, double second, long long n_op)
+{
+    printf("%-10s %-10s %10.3f s %10.1f ns/op\n", name, phase, second, second * 1e9 / n_op);
+}
+
+template <class Map>
+void run(const char *name)
+{
+    typedef typename Map::value_type value_type;
+    long long checksum = 0;
+    size_t heap = heapSize();
+    Map *map = new Map();
+
+    report(name, "insert", measure([&]() {
+               for (int key : keys)
+                   map->insert(value_type(key, key));
+           }),
+           keys.size());
+    double bytes = (double)(heapSize() - heap) / map->size();
+    report(name, "find_hit", measure([&]() {
+               for (int key : keys)
+                   checksum += map->find(key)->second;
+           }),
+           keys.size());
+    report(name, "find_miss", measure([&]() {
+               for (int key : misses)
+                   checksum += map->count(key);
+           }),
+           misses.size());
+    report(name, "iterate", measure([&]() {
+               for (auto it = map->begin(); it != map->end(); ++it)
+                   checksum += it->second;
+           }),
+           map->size());
+    report(name, "erase", measure([&]() {
+               for (int key : keys)
+                   map->erase(map->find(key));
+           }),
+           keys.size());
+    printf("%-10s %-10s %10.1f B/element, checksum %lld\n", name, "memory", bytes, checksum);
+    delete map;
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i], value = argv[i + 1];
+        if (option == "-n")
+            config.n = atoi(value.c_str());
+        else if (option == "-s")
+            config.seed = atoi(value.c_str());
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    // distinct even keys to insert, odd keys to miss
+    std::mt19937 rng(config.seed);
+    keys.resize(config.n);
+    for (int i = 0; i < config.n; ++i)
+        keys[i] = i * 2;
+    std::shuffle(keys.begin(), keys.end(), rng);
+    misses.resize(config.n);
+    for (int i = 0; i < config.n; ++i)
+        misses[i] = keys[i] + 1;
+
+    run<sjtu::map<int, int>>("map");
+    run<sjtu::btree_map<int, int>>("btree_map");
+    return 0;
+}
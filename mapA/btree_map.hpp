@@ -0,0 +1,824 @@
+/**
+ * an in-memory B+ tree with the interface of sjtu::map
+ */
+#ifndef SJTU_BTREE_MAP_HPP
+#define SJTU_BTREE_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+// B+ tree
+//  nodes follow B+Tree/BTree.hpp: a leaf keeps sorted keys and links to its brothers,
+//  key[i] of an internal node bounds child[i] from above, child[n_key] is unbounded
+// NOTE:
+//  1. a leaf keeps a copy of every key inline, so lookups never leave the node,
+//     and a pointer to the element, which is allocated once and never moves
+//  2. an iterator points to the element, and finds its leaf again by key
+//     after the map is modified, so it stays valid until its element is erased
+namespace sjtu
+{
+
+    template <class Key, class T, class Compare = std::less<Key>>
+    class btree_map
+    {
+    public:
+        typedef pair<const Key, T> value_type;
+
+    private:
+        // bytes of a node, 16 cache lines
+        static const int NODE_SIZE = 1024;
+        static const int MAX_HEIGHT = 40;
+        // (key, pointer) pairs of a node
+        static const int FIT = NODE_SIZE / (sizeof(Key) + sizeof(void *));
+
+        // max n_key of leaf, one more slot is reserved for split
+        static const int MAX_L = FIT > 4 ? FIT - 1 : 3;
+        static const int MIN_L = MAX_L >> 1;
+        // max n_child of internal node, one more slot is reserved for split
+        static const int MAX_M = FIT > 4 ? FIT : 4;
+        static const int MIN_M = (MAX_M - 1) >> 1; // of n_key
+
+        // keys are moved by memmove if possible
+        static const bool IS_TRIVIAL_KEY = std::is_trivially_copyable<Key>::value;
+
+        // raw array of N keys, constructed in place
+        template <int N>
+        struct KeyArray
+        {
+            typename std::aligned_storage<sizeof(Key), alignof(Key)>::type data[N];
+
+            Key &operator[](int i) { return *reinterpret_cast<Key *>(&data[i]); }
+            const Key &operator[](int i) const { return *reinterpret_cast<const Key *>(&data[i]); }
+
+            void construct(int i, const Key &key) { new (&data[i]) Key(key); }
+            void destroy(int i) { (*this)[i].~Key(); }
+
+            // move [lo, hi) to [lo + d, hi + d), d = -1 or 1
+            //  [lo + d, hi + d) \ [lo, hi) must be raw
+            void shift(int lo, int hi, int d)
+            {
+                if (IS_TRIVIAL_KEY)
+                {
+                    memmove((void *)&data[lo + d], (void *)&data[lo], sizeof(Key) * (hi - lo));
+                    return;
+                }
+                if (d > 0)
+                    for (int i = hi - 1; i >= lo; --i)
+                        relocate(*this, i, i + 1);
+                else
+                    for (int i = lo; i < hi; ++i)
+                        relocate(*this, i, i - 1);
+            }
+
+            // move [lo, hi) to other[pos, pos + hi - lo), which must be raw
+            template <int M>
+            void transfer(int lo, int hi, KeyArray<M> &other, int pos)
+            {
+                if (IS_TRIVIAL_KEY)
+                {
+                    memcpy((void *)&other.data[pos], (void *)&data[lo], sizeof(Key) * (hi - lo));
+                    return;
+                }
+                for (int i = lo; i < hi; ++i)
+                    relocate(other, i, pos + i - lo);
+            }
+
+            template <int M>
+            void relocate(KeyArray<M> &other, int from, int to)
+            {
+                new (&other.data[to]) Key(std::move((*this)[from]));
+                destroy(from);
+            }
+        };
+
+        struct Node
+        {
+            bool is_leaf;
+            int n_key;
+
+            Node(bool is_leaf) : is_leaf(is_leaf), n_key(0) {}
+        };
+
+        struct Leaf : Node
+        {
+            Leaf *prev, *succ;
+            KeyArray<MAX_L + 1> keys;
+            value_type *values[MAX_L + 1];
+
+            Leaf() : Node(true), prev(nullptr), succ(nullptr) {}
+            ~Leaf()
+            {
+                for (int i = 0; i < this->n_key; ++i)
+                {
+                    keys.destroy(i);
+                    delete values[i];
+                }
+            }
+
+            const Key &key(int k) const { return keys[k]; }
+
+            void insertData(int k, value_type *value)
+            {
+                keys.shift(k, this->n_key, 1);
+                keys.construct(k, value->first);
+                memmove(values + k + 1, values + k, sizeof(value_type *) * (this->n_key - k));
+                values[k] = value;
+                this->n_key++;
+            }
+
+            // move (key, value)[k] of other to pos
+            void insertData(int pos, Leaf &other, int k)
+            {
+                keys.shift(pos, this->n_key, 1);
+                other.keys.relocate(keys, k, pos);
+                other.keys.shift(k + 1, other.n_key, -1);
+                memmove(values + pos + 1, values + pos, sizeof(value_type *) * (this->n_key - pos));
+                values[pos] = other.values[k];
+                memmove(other.values + k, other.values + k + 1, sizeof(value_type *) * (other.n_key - k - 1));
+                this->n_key++, other.n_key--;
+            }
+
+            // NOTE: the element is not freed
+            void removeData(int k)
+            {
+                keys.destroy(k);
+                keys.shift(k + 1, this->n_key, -1);
+                memmove(values + k, values + k + 1, sizeof(value_type *) * (this->n_key - k - 1));
+                this->n_key--;
+            }
+        };
+
+        struct Internal : Node
+        {
+            KeyArray<MAX_M> keys;
+            Node *child[MAX_M + 1];
+
+            Internal() : Node(false) {}
+            ~Internal()
+            {
+                for (int i = 0; i < this->n_key; ++i)
+                    keys.destroy(i);
+            }
+
+            const Key &key(int k) const { return keys[k]; }
+
+            void setKey(int k, const Key &key)
+            {
+                keys.destroy(k);
+                keys.construct(k, key);
+            }
+
+            // insert key at k, and x at k + offset
+            void insertChild(int k, int offset, const Key &key, Node *x)
+            {
+                keys.shift(k, this->n_key, 1);
+                keys.construct(k, key);
+                memmove(child + k + offset + 1, child + k + offset,
+                        sizeof(Node *) * (this->n_key + 1 - k - offset));
+                child[k + offset] = x;
+                this->n_key++;
+            }
+
+            // remove key at k, and child at k + offset
+            void removeChild(int k, int offset)
+            {
+                keys.destroy(k);
+                keys.shift(k + 1, this->n_key, -1);
+                memmove(child + k + offset, child + k + offset + 1,
+                        sizeof(Node *) * (this->n_key - k - offset));
+                this->n_key--;
+            }
+        };
+
+        Compare compare_func;
+        Node *root;
+        Leaf *head, *tail; // sequential leaves
+        size_t n_element;
+        // changed by every insert / erase, iterators of an older version find their leaf again
+        size_t version;
+
+        // path of the last descend()
+        Internal *path[MAX_HEIGHT];
+        int slot[MAX_HEIGHT];
+
+        // >>>>>> utilities
+        // the first k that !(key[k] < target)
+        template <class X>
+        int lowerBound(const X *x, const Key &target) const
+        {
+            int lo = 0, hi = x->n_key;
+            while (lo < hi)
+            {
+                int mid = (lo + hi) >> 1;
+                if (compare_func(x->key(mid), target))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+        // fill path and slot
+        //  returns: depth of leaf
+        int descend(const Key &key)
+        {
+            int d = 0;
+            Node *x = root;
+            while (!x->is_leaf)
+            {
+                Internal *y = static_cast<Internal *>(x);
+                path[d] = y;
+                slot[d] = lowerBound(y, key);
+                x = y->child[slot[d]];
+                d++;
+            }
+            slot[d] = lowerBound(static_cast<Leaf *>(x), key);
+            return d;
+        }
+
+        Leaf *leafAt(int d) const
+        {
+            return static_cast<Leaf *>(d == 0 ? root : path[d - 1]->child[slot[d - 1]]);
+        }
+
+        // k: slot of key in the leaf, n_key if key is not found
+        //  returns: the leaf
+        Leaf *locate(const Key &key, int &k) const
+        {
+            const Node *x = root;
+            while (!x->is_leaf)
+            {
+                const Internal *y = static_cast<const Internal *>(x);
+                x = y->child[lowerBound(y, key)];
+            }
+            Leaf *leaf = const_cast<Leaf *>(static_cast<const Leaf *>(x));
+            k = lowerBound(leaf, key);
+            if (k < leaf->n_key && compare_func(key, leaf->key(k)))
+                k = leaf->n_key;
+            return leaf;
+        }
+
+        // find the leaf of an iterator again, if the map has changed
+        void sync(const value_type *ptr, Leaf *&leaf, int &k, size_t &it_version) const
+        {
+            if (it_version != version)
+            {
+                leaf = locate(ptr->first, k);
+                it_version = version;
+            }
+        }
+
+        void destruct(Node *x)
+        {
+            if (x->is_leaf)
+            {
+                delete static_cast<Leaf *>(x);
+                return;
+            }
+            Internal *y = static_cast<Internal *>(x);
+            for (int i = 0; i <= y->n_key; ++i)
+                destruct(y->child[i]);
+            delete y;
+        }
+
+        // copy the subtree of other, leaves are linked after tail
+        Node *construct(const Node *other)
+        {
+            if (other->is_leaf)
+            {
+                const Leaf *y = static_cast<const Leaf *>(other);
+                Leaf *x = new Leaf();
+                for (int i = 0; i < y->n_key; ++i)
+                {
+                    x->keys.construct(i, y->keys[i]);
+                    x->values[i] = new value_type(*y->values[i]);
+                }
+                x->n_key = y->n_key;
+                x->prev = tail;
+                if (tail != nullptr)
+                    tail->succ = x;
+                else
+                    head = x;
+                tail = x;
+                return x;
+            }
+            const Internal *y = static_cast<const Internal *>(other);
+            Internal *x = new Internal();
+            for (int i = 0; i < y->n_key; ++i)
+                x->keys.construct(i, y->keys[i]);
+            x->n_key = y->n_key;
+            for (int i = 0; i <= y->n_key; ++i)
+                x->child[i] = construct(y->child[i]);
+            return x;
+        }
+
+        void copyFrom(const btree_map &other)
+        {
+            head = tail = nullptr;
+            root = construct(other.root);
+            n_element = other.n_element;
+            version = 0;
+        }
+
+        void reset()
+        {
+            head = tail = new Leaf();
+            root = head;
+            n_element = 0;
+            version = 0;
+        }
+        // <<<<<< utilities
+
+        // >>>>> insert
+        // split x into x & succ, as BTree::split
+        //  new_key: the max key of x
+        //  returns: succ
+        Node *split(Leaf *x, const Key *&new_key)
+        {
+            Leaf *succ = new Leaf();
+            succ->prev = x;
+            succ->succ = x->succ;
+            if (x->succ != nullptr)
+                x->succ->prev = succ;
+            else
+                tail = succ;
+            x->succ = succ;
+
+            int n_key = x->n_key;
+            x->n_key = n_key >> 1;
+            succ->n_key = n_key - x->n_key;
+            x->keys.transfer(x->n_key, n_key, succ->keys, 0);
+            memcpy(succ->values, x->values + x->n_key, sizeof(value_type *) * succ->n_key);
+            new_key = &x->key(x->n_key - 1);
+            return succ;
+        }
+
+        //  new_key: key[n_key] of x, which goes up and is no longer owned by x,
+        //  the caller destroys it once it is copied
+        Node *split(Internal *x, Key *&new_key)
+        {
+            Internal *succ = new Internal();
+            x->n_key = (MAX_M - 1) >> 1;
+            succ->n_key = MAX_M - x->n_key - 1;
+            x->keys.transfer(x->n_key + 1, MAX_M, succ->keys, 0);
+            memcpy(succ->child, x->child + x->n_key + 1, sizeof(Node *) * (succ->n_key + 1));
+            new_key = &x->keys[x->n_key];
+            return succ;
+        }
+
+        // leaf, k: where value is, or the element that prevented the insertion
+        //  returns: is_inserted
+        bool insertValue(const value_type &value, Leaf *&leaf, int &k)
+        {
+            int d = descend(value.first);
+            leaf = leafAt(d);
+            k = slot[d];
+            if (k < leaf->n_key && !compare_func(value.first, leaf->key(k)))
+                return false;
+
+            leaf->insertData(k, new value_type(value));
+            n_element++, version++;
+            if (leaf->n_key <= MAX_L)
+                return true;
+
+            const Key *new_key;
+            Node *succ = split(leaf, new_key);
+            if (k >= leaf->n_key)
+                k -= leaf->n_key, leaf = static_cast<Leaf *>(succ);
+            // the key handed up by an internal split, destroyed once it is copied
+            Key *orphan = nullptr;
+            for (--d; d >= 0; --d)
+            {
+                Internal *x = path[d];
+                x->insertChild(slot[d], 1, *new_key, succ);
+                if (orphan != nullptr)
+                    orphan->~Key(), orphan = nullptr;
+                if (x->n_key < MAX_M)
+                    return true;
+                succ = split(x, orphan);
+                new_key = orphan;
+            }
+
+            // grow taller
+            Internal *x = new Internal();
+            x->n_key = 1;
+            x->keys.construct(0, *new_key);
+            if (orphan != nullptr)
+                orphan->~Key();
+            x->child[0] = root;
+            x->child[1] = succ;
+            root = x;
+            return true;
+        }
+        // <<<<< insert
+
+        // >>>>> remove
+        bool isUnderflow(const Node *x) const
+        {
+            return x->n_key < (x->is_leaf ? MIN_L : MIN_M);
+        }
+
+        bool canLend(const Node *x) const
+        {
+            return x != nullptr && x->n_key > (x->is_leaf ? MIN_L : MIN_M);
+        }
+
+        // rotate from left/right brother
+        bool rotate(Internal *x, int k, Node *child, Node *left, Node *right)
+        {
+            if (canLend(left))
+            {
+                if (child->is_leaf)
+                {
+                    Leaf *y = static_cast<Leaf *>(left);
+                    static_cast<Leaf *>(child)->insertData(0, *y, y->n_key - 1);
+                    x->setKey(k - 1, y->key(y->n_key - 1));
+                }
+                else
+                {
+                    Internal *y = static_cast<Internal *>(left);
+                    static_cast<Internal *>(child)->insertChild(0, 0, x->key(k - 1), y->child[y->n_key]);
+                    x->setKey(k - 1, y->key(y->n_key - 1));
+                    y->removeChild(y->n_key - 1, 1);
+                }
+                return true;
+            }
+            if (canLend(right))
+            {
+                if (child->is_leaf)
+                {
+                    Leaf *y = static_cast<Leaf *>(child);
+                    y->insertData(y->n_key, *static_cast<Leaf *>(right), 0);
+                    x->setKey(k, y->key(y->n_key - 1));
+                }
+                else
+                {
+                    Internal *y = static_cast<Internal *>(right);
+                    Internal *z = static_cast<Internal *>(child);
+                    z->insertChild(z->n_key, 1, x->key(k), y->child[0]);
+                    x->setKey(k, y->key(0));
+                    y->removeChild(0, 0);
+                }
+                return true;
+            }
+            return false;
+        }
+
+        // move everything of right into left, key is the separator between them
+        void append(Node *left, Node *right, const Key &key)
+        {
+            if (left->is_leaf)
+            {
+                Leaf *x = static_cast<Leaf *>(left), *y = static_cast<Leaf *>(right);
+                y->keys.transfer(0, y->n_key, x->keys, x->n_key);
+                memcpy(x->values + x->n_key, y->values, sizeof(value_type *) * y->n_key);
+                x->n_key += y->n_key;
+                y->n_key = 0;
+                x->succ = y->succ;
+                if (y->succ != nullptr)
+                    y->succ->prev = x;
+                else
+                    tail = x;
+                delete y;
+                return;
+            }
+            Internal *x = static_cast<Internal *>(left), *y = static_cast<Internal *>(right);
+            x->insertChild(x->n_key, 1, key, y->child[0]);
+            y->keys.transfer(0, y->n_key, x->keys, x->n_key);
+            memcpy(x->child + x->n_key + 1, y->child + 1, sizeof(Node *) * y->n_key);
+            x->n_key += y->n_key;
+            y->n_key = 0;
+            delete y;
+        }
+
+        // merge with left/right brother
+        void merge(Internal *x, int k, Node *child, Node *left, Node *right)
+        {
+            if (left != nullptr)
+            {
+                append(left, child, x->key(k - 1));
+                x->removeChild(k - 1, 1);
+            }
+            else
+            {
+                append(child, right, x->key(k));
+                x->removeChild(k, 1);
+            }
+        }
+
+        // rebalance bottom-up along the path
+        //  1. rotate
+        //  2. merge
+        // NOTE: key[k] of a parent is not updated when its max key is removed,
+        //  it still bounds child[k] from above
+        bool remove(const Key &key)
+        {
+            int d = descend(key);
+            Leaf *leaf = leafAt(d);
+            int k = slot[d];
+            if (k == leaf->n_key || compare_func(key, leaf->key(k)))
+                return false;
+
+            // key may belong to the element, which is freed at last
+            value_type *value = leaf->values[k];
+            leaf->removeData(k);
+            n_element--, version++;
+            Node *child = leaf;
+            for (--d; d >= 0 && isUnderflow(child); --d)
+            {
+                Internal *x = path[d];
+                int k = slot[d];
+                Node *left = k > 0 ? x->child[k - 1] : nullptr;
+                Node *right = k < x->n_key ? x->child[k + 1] : nullptr;
+                if (!rotate(x, k, child, left, right))
+                    merge(x, k, child, left, right);
+                child = x;
+            }
+
+            if (!root->is_leaf && root->n_key == 0)
+            {
+                Internal *x = static_cast<Internal *>(root);
+                root = x->child[0];
+                delete x;
+            }
+            delete value;
+            return true;
+        }
+        // <<<<< remove
+
+    public:
+        class const_iterator;
+        // end() points to nullptr
+        //  if there is anything wrong throw invalid_iterator.
+        class iterator
+        {
+            friend class btree_map<Key, T, Compare>;
+            friend class const_iterator;
+
+        private:
+            btree_map<Key, T, Compare> *map_ptr;
+            value_type *ptr;
+            // position of ptr at version
+            Leaf *leaf;
+            int k;
+            size_t version;
+
+        public:
+            iterator() : map_ptr(nullptr), ptr(nullptr), leaf(nullptr), k(0), version(0) {}
+            iterator(btree_map<Key, T, Compare> *map_ptr, Leaf *leaf, int k)
+                : map_ptr(map_ptr), ptr(leaf == nullptr ? nullptr : leaf->values[k]),
+                  leaf(leaf), k(k), version(map_ptr->version) {}
+
+            iterator operator++(int)
+            {
+                iterator ret(*this);
+                ++*this;
+                return ret;
+            }
+            iterator &operator++()
+            {
+                if (ptr == nullptr)
+                    throw invalid_iterator();
+                map_ptr->sync(ptr, leaf, k, version);
+                if (++k == leaf->n_key)
+                    leaf = leaf->succ, k = 0;
+                ptr = leaf == nullptr ? nullptr : leaf->values[k];
+                return *this;
+            }
+            iterator operator--(int)
+            {
+                iterator ret(*this);
+                --*this;
+                return ret;
+            }
+            iterator &operator--()
+            {
+                if (ptr == nullptr)
+                {
+                    if (map_ptr == nullptr || map_ptr->n_element == 0)
+                        throw invalid_iterator();
+                    leaf = map_ptr->tail, k = leaf->n_key, version = map_ptr->version;
+                }
+                else
+                {
+                    map_ptr->sync(ptr, leaf, k, version);
+                    if (k == 0)
+                    {
+                        if (leaf->prev == nullptr)
+                            throw invalid_iterator();
+                        leaf = leaf->prev, k = leaf->n_key;
+                    }
+                }
+                ptr = leaf->values[--k];
+                return *this;
+            }
+
+            value_type &operator*() const { return *ptr; }
+            value_type *operator->() const noexcept { return ptr; }
+
+            bool operator==(const iterator &rhs) const
+            {
+                return map_ptr == rhs.map_ptr && ptr == rhs.ptr;
+            }
+            bool operator==(const const_iterator &rhs) const
+            {
+                return map_ptr == rhs.map_ptr && ptr == rhs.ptr;
+            }
+            bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+            bool operator!=(const const_iterator &rhs) const { return !(*this == rhs); }
+        };
+        class const_iterator
+        {
+            friend class btree_map<Key, T, Compare>;
+            friend class iterator;
+
+        private:
+            const btree_map<Key, T, Compare> *map_ptr;
+            const value_type *ptr;
+            Leaf *leaf;
+            int k;
+            size_t version;
+
+        public:
+            const_iterator() : map_ptr(nullptr), ptr(nullptr), leaf(nullptr), k(0), version(0) {}
+            const_iterator(const btree_map<Key, T, Compare> *map_ptr, Leaf *leaf, int k)
+                : map_ptr(map_ptr), ptr(leaf == nullptr ? nullptr : leaf->values[k]),
+                  leaf(leaf), k(k), version(map_ptr->version) {}
+            const_iterator(const iterator &other)
+                : map_ptr(other.map_ptr), ptr(other.ptr),
+                  leaf(other.leaf), k(other.k), version(other.version) {}
+
+            const_iterator operator++(int)
+            {
+                const_iterator ret(*this);
+                ++*this;
+                return ret;
+            }
+            const_iterator &operator++()
+            {
+                if (ptr == nullptr)
+                    throw invalid_iterator();
+                map_ptr->sync(ptr, leaf, k, version);
+                if (++k == leaf->n_key)
+                    leaf = leaf->succ, k = 0;
+                ptr = leaf == nullptr ? nullptr : leaf->values[k];
+                return *this;
+            }
+            const_iterator operator--(int)
+            {
+                const_iterator ret(*this);
+                --*this;
+                return ret;
+            }
+            const_iterator &operator--()
+            {
+                if (ptr == nullptr)
+                {
+                    if (map_ptr == nullptr || map_ptr->n_element == 0)
+                        throw invalid_iterator();
+                    leaf = map_ptr->tail, k = leaf->n_key, version = map_ptr->version;
+                }
+                else
+                {
+                    map_ptr->sync(ptr, leaf, k, version);
+                    if (k == 0)
+                    {
+                        if (leaf->prev == nullptr)
+                            throw invalid_iterator();
+                        leaf = leaf->prev, k = leaf->n_key;
+                    }
+                }
+                ptr = leaf->values[--k];
+                return *this;
+            }
+
+            const value_type &operator*() const { return *ptr; }
+            const value_type *operator->() const noexcept { return ptr; }
+
+            bool operator==(const iterator &rhs) const
+            {
+                return map_ptr == rhs.map_ptr && ptr == rhs.ptr;
+            }
+            bool operator==(const const_iterator &rhs) const
+            {
+                return map_ptr == rhs.map_ptr && ptr == rhs.ptr;
+            }
+            bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+            bool operator!=(const const_iterator &rhs) const { return !(*this == rhs); }
+        };
+
+        btree_map() { reset(); }
+        btree_map(const btree_map &other) { copyFrom(other); }
+        btree_map &operator=(const btree_map &other)
+        {
+            if (this != &other)
+            {
+                destruct(root);
+                copyFrom(other);
+            }
+            return *this;
+        }
+        ~btree_map() { destruct(root); }
+
+        /**
+         * access specified element with bounds checking
+         * throw index_out_of_bound if such key does not exist.
+         */
+        T &at(const Key &key)
+        {
+            int k;
+            Leaf *leaf = locate(key, k);
+            if (k == leaf->n_key)
+                throw index_out_of_bound();
+            return leaf->values[k]->second;
+        }
+        const T &at(const Key &key) const
+        {
+            int k;
+            Leaf *leaf = locate(key, k);
+            if (k == leaf->n_key)
+                throw index_out_of_bound();
+            return leaf->values[k]->second;
+        }
+        /**
+         * access specified element
+         *   performing an insertion if such key does not already exist.
+         */
+        T &operator[](const Key &key)
+        {
+            int k;
+            Leaf *leaf = locate(key, k);
+            if (k == leaf->n_key)
+                insertValue(value_type(key, T()), leaf, k);
+            return leaf->values[k]->second;
+        }
+        const T &operator[](const Key &key) const { return at(key); }
+
+        iterator begin() { return iterator(this, n_element == 0 ? nullptr : head, 0); }
+        const_iterator cbegin() const { return const_iterator(this, n_element == 0 ? nullptr : head, 0); }
+        iterator end() { return iterator(this, nullptr, 0); }
+        const_iterator cend() const { return const_iterator(this, nullptr, 0); }
+
+        bool empty() const { return n_element == 0; }
+        size_t size() const { return n_element; }
+
+        void clear()
+        {
+            destruct(root);
+            reset();
+        }
+
+        /**
+         * return a pair, the first of the pair is
+         *   the iterator to the new element (or the element that prevented the insertion),
+         *   the second one is true if insert successfully, or false.
+         */
+        pair<iterator, bool> insert(const value_type &value)
+        {
+            Leaf *leaf;
+            int k;
+            bool is_inserted = insertValue(value, leaf, k);
+            return pair<iterator, bool>(iterator(this, leaf, k), is_inserted);
+        }
+
+        /**
+         * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
+         */
+        void erase(iterator pos)
+        {
+            if (pos.map_ptr != this || pos.ptr == nullptr)
+                throw invalid_iterator();
+            if (!remove(pos.ptr->first))
+                throw invalid_iterator();
+        }
+
+        size_t count(const Key &key) const
+        {
+            int k;
+            Leaf *leaf = locate(key, k);
+            return k != leaf->n_key;
+        }
+
+        iterator find(const Key &key)
+        {
+            int k;
+            Leaf *leaf = locate(key, k);
+            return k == leaf->n_key ? end() : iterator(this, leaf, k);
+        }
+        const_iterator find(const Key &key) const
+        {
+            int k;
+            Leaf *leaf = locate(key, k);
+            return k == leaf->n_key ? cend() : const_iterator(this, leaf, k);
+        }
+    };
+
+}
+
+#endif
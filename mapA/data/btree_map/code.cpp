@@ -0,0 +1,189 @@
+// btree_map: random operations against std::map
+//  with int keys, std::string keys, a reversed Compare,
+//  and keys so large that a node holds only a few of them
+//  g++ -O2 -std=c++14 -I../.. code.cpp
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include "btree_map.hpp"
+
+using namespace std;
+
+// about 4 keys a node, so that every operation splits, rotates or merges
+struct Big {
+    int v;
+    char pad[252];
+
+    Big(int v = 0) : v(v) {}
+    bool operator<(const Big &other) const { return v < other.v; }
+    bool operator==(const Big &other) const { return v == other.v; }
+    bool operator!=(const Big &other) const { return v != other.v; }
+};
+
+template <class Key>
+Key makeKey(int x);
+template <>
+int makeKey<int>(int x) { return x; }
+template <>
+string makeKey<string>(int x) { return "key" + to_string(x); }
+template <>
+Big makeKey<Big>(int x) { return Big(x); }
+
+template <class Key, class Compare>
+class Test {
+    typedef sjtu::btree_map<Key, int, Compare> Map;
+    typedef map<Key, int, Compare> Expected;
+
+    Map m;
+    Expected expected;
+    mt19937 rng;
+    int n_key;
+
+    Key randomKey() { return makeKey<Key>(rng() % n_key); }
+
+    bool same(const Map &a) {
+        if (a.size() != expected.size())
+            return false;
+        typename Map::const_iterator jt = a.cbegin();
+        for (auto &p : expected) {
+            if (jt == a.cend() || jt->first != p.first || jt->second != p.second)
+                return false;
+            ++jt;
+        }
+        if (jt != a.cend())
+            return false;
+        // backward
+        for (auto it = expected.rbegin(); it != expected.rend(); ++it)
+            if ((--jt)->first != it->first)
+                return false;
+        return expected.empty() || jt == a.cbegin();
+    }
+
+    // walk up to 10 steps both ways from key
+    bool walk(const Key &key) {
+        auto it = expected.find(key);
+        typename Map::iterator jt = m.find(key);
+        if ((it == expected.end()) != (jt == m.end()))
+            return false;
+        if (it == expected.end())
+            return true;
+        auto it2 = it;
+        typename Map::iterator jt2 = jt;
+        for (int i = 0; i < 10 && it2 != expected.end(); ++i, ++it2, ++jt2)
+            if (jt2 == m.end() || jt2->first != it2->first || jt2->second != it2->second)
+                return false;
+        for (int i = 0; i < 10 && it != expected.begin(); ++i)
+            if ((--jt)->first != (--it)->first)
+                return false;
+        return true;
+    }
+
+    bool step() {
+        int op = rng() % 10;
+        Key key = randomKey();
+        int value = rng() % 1000000;
+        if (op < 3) {
+            auto result = m.insert(sjtu::pair<const Key, int>(key, value));
+            bool is_inserted = expected.insert(make_pair(key, value)).second;
+            return result.second == is_inserted && result.first->first == key &&
+                   result.first->second == expected[key];
+        }
+        if (op < 4) {
+            m[key] += value;
+            expected[key] += value;
+            return m[key] == expected[key];
+        }
+        if (op < 6) {
+            typename Map::iterator jt = m.find(key);
+            if ((jt == m.end()) != (expected.count(key) == 0))
+                return false;
+            if (jt != m.end())
+                m.erase(jt);
+            expected.erase(key);
+            return m.count(key) == 0;
+        }
+        if (op < 7) {
+            auto it = expected.find(key);
+            try {
+                int v = m.at(key);
+                return it != expected.end() && v == it->second;
+            } catch (sjtu::index_out_of_bound &) {
+                return it == expected.end();
+            }
+        }
+        if (op < 9)
+            return walk(key);
+        // erase(it++) over a run of elements
+        typename Map::iterator jt = m.find(key);
+        auto it = expected.find(key);
+        for (int i = 0; i < 5 && it != expected.end(); ++i) {
+            if (jt == m.end() || jt->first != it->first)
+                return false;
+            m.erase(jt++);
+            it = expected.erase(it);
+        }
+        return (it == expected.end()) == (jt == m.end());
+    }
+
+public:
+    Test(unsigned seed, int n_key) : rng(seed), n_key(n_key) {}
+
+    void run(const char *name, int n_op) {
+        cout << name << ": ";
+        // an iterator held across operations on other elements
+        typename Map::iterator held;
+        Key held_key;
+        bool is_held = false;
+        for (int i = 0; i < n_op; ++i) {
+            if (!step()) {
+                cout << "wrong at op " << i << endl;
+                return;
+            }
+            // NOTE: an iterator to an erased element is invalid, even if its key comes back
+            if (expected.count(held_key) == 0)
+                is_held = false;
+            if (is_held && (held->first != held_key || held->second != expected[held_key])) {
+                cout << "wrong held iterator at op " << i << endl;
+                return;
+            }
+            if (i % 1000 == 0) {
+                held_key = randomKey();
+                held = m.find(held_key);
+                is_held = held != m.end();
+            }
+            if (i % 20000 == 19999) {
+                Map other(m);
+                m.clear();
+                m = other;
+                is_held = false;
+                if (!same(other) || !same(m)) {
+                    cout << "wrong copy at op " << i << endl;
+                    return;
+                }
+            }
+        }
+        try {
+            m.erase(m.end());
+            cout << "erase(end()) does not throw" << endl;
+            return;
+        } catch (sjtu::invalid_iterator &) {
+        }
+        long long sum = 0;
+        for (auto &p : expected)
+            sum += p.second;
+        cout << (same(m) ? "ok " : "wrong scan ") << m.size() << ' ' << sum << endl;
+    }
+};
+
+int main() {
+    Test<int, less<int>>(1, 50000).run("int", 300000);
+    Test<int, less<int>>(2, 200).run("int dense", 100000);
+    Test<int, greater<int>>(3, 50000).run("int greater", 200000);
+    Test<string, less<string>>(4, 30000).run("string", 200000);
+    Test<Big, less<Big>>(5, 5000).run("big", 100000);
+    Test<Big, less<Big>>(6, 50).run("big dense", 50000);
+    return 0;
+}
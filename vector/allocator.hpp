@@ -0,0 +1,295 @@
+#ifndef SJTU_ALLOCATOR_HPP
+#define SJTU_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace sjtu
+{
+    /**
+     * a monotonic memory resource
+     * allocation bumps a pointer in the current chunk, deallocation does nothing,
+     *   and everything is freed at once by reset() or the destructor.
+     */
+    // NOTE: chunks grow geometrically from chunk_size,
+    //  and reset() keeps only the last (largest) one, so a reused arena stops allocating
+    //  not thread safe
+    class arena
+    {
+    private:
+        struct Chunk
+        {
+            Chunk *next;
+            size_t size; // in bytes, including this header
+        };
+        static const size_t HEADER_SIZE = (sizeof(Chunk) + alignof(std::max_align_t) - 1) /
+                                          alignof(std::max_align_t) * alignof(std::max_align_t);
+
+        Chunk *head;
+        char *cur, *end;
+        size_t chunk_size;
+        size_t n_allocation, n_byte, n_chunk;
+
+        // a new head of at least n bytes after the header
+        void expand(size_t n)
+        {
+            size_t size = head ? head->size << 1 : chunk_size;
+            while (size < n + HEADER_SIZE)
+                size <<= 1;
+            Chunk *chunk = static_cast<Chunk *>(::operator new(size));
+            chunk->next = head;
+            chunk->size = size;
+            head = chunk;
+            cur = reinterpret_cast<char *>(chunk) + HEADER_SIZE;
+            end = reinterpret_cast<char *>(chunk) + size;
+            n_chunk++;
+        }
+
+    public:
+        explicit arena(size_t chunk_size = 1 << 16)
+            : head(nullptr), cur(nullptr), end(nullptr), chunk_size(chunk_size),
+              n_allocation(0), n_byte(0), n_chunk(0) {}
+        arena(const arena &) = delete;
+        arena &operator=(const arena &) = delete;
+        ~arena()
+        {
+            while (head)
+            {
+                Chunk *next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+
+        // align should be a power of 2, no more than alignof(std::max_align_t)
+        void *allocate(size_t n, size_t align)
+        {
+            n_allocation++;
+            n_byte += n;
+            size_t pad = -reinterpret_cast<size_t>(cur) & (align - 1);
+            if (cur == nullptr || pad + n > (size_t)(end - cur))
+            {
+                expand(n);
+                pad = 0;
+            }
+            void *ret = cur + pad;
+            cur += pad + n;
+            return ret;
+        }
+
+        // frees every allocation
+        void reset()
+        {
+            if (head == nullptr)
+                return;
+            while (head->next)
+            {
+                Chunk *next = head->next->next;
+                ::operator delete(head->next);
+                head->next = next;
+            }
+            cur = reinterpret_cast<char *>(head) + HEADER_SIZE;
+        }
+
+        size_t allocations() const { return n_allocation; }
+        size_t bytes() const { return n_byte; }
+        // calls to ::operator new
+        size_t chunks() const { return n_chunk; }
+    };
+
+    /**
+     * a memory resource with free lists of power-of-2 size classes
+     * blocks are carved from slabs and recycled within their class,
+     *   larger requests go to ::operator new directly.
+     */
+    // NOTE: slabs are returned only by the destructor
+    //  not thread safe
+    class pool
+    {
+    private:
+        static const size_t MIN_SHIFT = 4;  // 16 bytes
+        static const size_t MAX_SHIFT = 12; // 4 KiB
+        static const size_t N_CLASS = MAX_SHIFT - MIN_SHIFT + 1;
+        static const size_t SLAB_SIZE = 1 << 16;
+
+        struct Block
+        {
+            Block *next;
+        };
+
+        Block *free_list[N_CLASS];
+        Block *slabs; // linked through their first block
+        size_t n_allocation, n_recycle, n_heap;
+
+        static size_t sizeClass(size_t n)
+        {
+            size_t ret = 0;
+            while ((size_t)1 << (ret + MIN_SHIFT) < n)
+                ret++;
+            return ret;
+        }
+
+        // fill the empty free list of class c from a new slab
+        void refill(size_t c)
+        {
+            size_t size = (size_t)1 << (c + MIN_SHIFT);
+            char *slab = static_cast<char *>(::operator new(SLAB_SIZE));
+            n_heap++;
+            reinterpret_cast<Block *>(slab)->next = slabs;
+            slabs = reinterpret_cast<Block *>(slab);
+            // the first block keeps the slab list
+            for (size_t offset = SLAB_SIZE - size; offset >= size; offset -= size)
+            {
+                Block *block = reinterpret_cast<Block *>(slab + offset);
+                block->next = free_list[c];
+                free_list[c] = block;
+            }
+        }
+
+    public:
+        pool() : slabs(nullptr), n_allocation(0), n_recycle(0), n_heap(0)
+        {
+            for (size_t i = 0; i < N_CLASS; ++i)
+                free_list[i] = nullptr;
+        }
+        pool(const pool &) = delete;
+        pool &operator=(const pool &) = delete;
+        ~pool()
+        {
+            while (slabs)
+            {
+                Block *next = slabs->next;
+                ::operator delete(slabs);
+                slabs = next;
+            }
+        }
+
+        void *allocate(size_t n)
+        {
+            n_allocation++;
+            if (n > (size_t)1 << MAX_SHIFT)
+            {
+                n_heap++;
+                return ::operator new(n);
+            }
+            size_t c = sizeClass(n);
+            if (free_list[c] == nullptr)
+                refill(c);
+            else
+                n_recycle++;
+            Block *ret = free_list[c];
+            free_list[c] = ret->next;
+            return ret;
+        }
+
+        // n should be the size passed to allocate()
+        void deallocate(void *p, size_t n)
+        {
+            if (n > (size_t)1 << MAX_SHIFT)
+            {
+                ::operator delete(p);
+                return;
+            }
+            size_t c = sizeClass(n);
+            Block *block = static_cast<Block *>(p);
+            block->next = free_list[c];
+            free_list[c] = block;
+        }
+
+        size_t allocations() const { return n_allocation; }
+        // allocations served from a free list
+        size_t recycled() const { return n_recycle; }
+        // calls to ::operator new, for slabs or large blocks
+        size_t heap_allocations() const { return n_heap; }
+    };
+
+    /**
+     * an allocator drawing from an arena
+     * it follows its memory: copies, moves and swaps of containers carry it along.
+     */
+    template <class T>
+    class arena_allocator
+    {
+        template <class U>
+        friend class arena_allocator;
+
+    private:
+        arena *resource;
+
+    public:
+        typedef T value_type;
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        arena_allocator(arena &resource) : resource(&resource) {}
+        template <class U>
+        arena_allocator(const arena_allocator<U> &other) : resource(other.resource) {}
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(resource->allocate(sizeof(T) * n, alignof(T)));
+        }
+        void deallocate(T *, size_t) {}
+
+        template <class U>
+        bool operator==(const arena_allocator<U> &rhs) const
+        {
+            return resource == rhs.resource;
+        }
+        template <class U>
+        bool operator!=(const arena_allocator<U> &rhs) const
+        {
+            return resource != rhs.resource;
+        }
+    };
+
+    /**
+     * an allocator drawing from a pool
+     * as std::pmr, it never propagates: a container keeps its pool for life,
+     *   and moving between pools moves the elements one by one.
+     */
+    template <class T>
+    class pool_allocator
+    {
+        template <class U>
+        friend class pool_allocator;
+
+    private:
+        pool *resource;
+
+    public:
+        typedef T value_type;
+        typedef std::false_type propagate_on_container_copy_assignment;
+        typedef std::false_type propagate_on_container_move_assignment;
+        typedef std::false_type propagate_on_container_swap;
+
+        pool_allocator(pool &resource) : resource(&resource) {}
+        template <class U>
+        pool_allocator(const pool_allocator<U> &other) : resource(other.resource) {}
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(resource->allocate(sizeof(T) * n));
+        }
+        void deallocate(T *p, size_t n)
+        {
+            resource->deallocate(p, sizeof(T) * n);
+        }
+
+        template <class U>
+        bool operator==(const pool_allocator<U> &rhs) const
+        {
+            return resource == rhs.resource;
+        }
+        template <class U>
+        bool operator!=(const pool_allocator<U> &rhs) const
+        {
+            return resource != rhs.resource;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,412 @@
+// benchmark of sjtu::vector, with std::vector for reference
+//  g++ -O2 -std=c++14 -pthread bench.cpp -o bench
+//  add -DNDEBUG for unchecked operator[] and pointer iterators of sjtu::vector
+//  ./bench [-n elements] [-s seed]
+// phases: push_back, seq_read (operator[]), iterate (iterator), rand_read,
+//  accumulate and sort (std:: algorithms over the iterators, sort after a shuffle),
+//  mid_insert / mid_erase (100 of them, in the middle), reported in GB/s of elements shifted,
+//  blk_insert / blk_erase (range insert / erase of 10 blocks of 1000 in the middle), per element
+//  memory per element is the growth of the heap (mallinfo2) after push_back,
+//  including blocks served by mmap
+// short-lived vectors of 16 ints, n / 4 of them in requests of 1000,
+//  by std::vector, by sjtu::vector with std::allocator, an arena reset after each request
+//  and a pool (with their calls to ::operator new), and by sjtu::small_vector<int, 16>
+// sjtu::mmap_vector<int> of n elements in mmap_vector.bin, removed after:
+//  push_back, sync, reopen (open + map, O(1)), first_read of the middle, seq_read
+// concurrent push_back of n ints by 1 to 32 threads:
+//  sjtu::segmented_vector lock free, std::vector and sjtu::vector behind a std::mutex
+// heavy payloads of vector/data, n / 100 of them:
+//  push_back of temporaries, insert at the front,
+//  and a vector passed through a function by value and assigned back
+// search and reductions of simd.hpp over vectors of int, long long and double of 1K to 100M,
+//  repeated up to 100M elements, in GB/s: sjtu:: (AVX2 if the CPU has it),
+//  a naive loop over operator[] and the std:: algorithm over the iterators
+//  find and count look for a value which is absent
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <malloc.h>
+#include "vector.hpp"
+#include "allocator.hpp"
+#include "small_vector.hpp"
+#include "mmap_vector.hpp"
+#include "segmented_vector.hpp"
+#include "simd.hpp"
+#include "data/class-bint.hpp"
+#include "data/class-matrix.hpp"
+
+// Bint owns its digits through a pointer
+namespace sjtu
+{
+    template <>
+    struct is_trivially_relocatable<Util::Bint> : std::true_type
+    {
+    };
+}
+
+struct Config
+{
+    int n = 10000000;
+    unsigned seed = 2020;
+};
+
+// a payload larger than a pointer
+struct Point
+{
+    long long x, y, z;
+
+    Point(long long x) : x(x), y(x + 1), z(x + 2) {}
+    operator long long() const { return x + y + z; }
+};
+
+Config config;
+std::vector<int> order; // of rand_read
+
+size_t heapSize()
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+template <class F>
+double measure(F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const std::string &name, const char *phase, double second, long long n_op)
+{
+    printf("%-22s %-10s %10.3f s %10.2f ns/op\n", name.c_str(), phase, second, second * 1e9 / n_op);
+}
+
+template <class Vector, class T>
+void run(const std::string &name)
+{
+    long long checksum = 0;
+    int n = config.n;
+    size_t heap = heapSize();
+    Vector *v = new Vector();
+
+    report(name, "push_back", measure([&]() {
+               for (int i = 0; i < n; ++i)
+                   v->push_back(T(i));
+           }),
+           n);
+    double bytes = (double)(heapSize() - heap) / n;
+    report(name, "seq_read", measure([&]() {
+               for (int i = 0; i < n; ++i)
+                   checksum += (*v)[i];
+           }),
+           n);
+    report(name, "iterate", measure([&]() {
+               for (auto it = v->begin(); it != v->end(); ++it)
+                   checksum += *it;
+           }),
+           n);
+    report(name, "rand_read", measure([&]() {
+               for (int i : order)
+                   checksum += (*v)[i];
+           }),
+           n);
+    report(name, "accumulate", measure([&]() {
+               checksum += std::accumulate(v->begin(), v->end(), 0LL);
+           }),
+           n);
+    for (int i = 0; i < n; ++i)
+        (*v)[i] = T(order[i]);
+    report(name, "sort", measure([&]() {
+               std::sort(v->begin(), v->end());
+           }),
+           n);
+    checksum += (*v)[n / 3];
+    const int N_MID = 100;
+    double shifted = (double)sizeof(T) * n / 2 * N_MID / 1e9; // GB
+    double second = measure([&]() {
+        for (int i = 0; i < N_MID; ++i)
+            v->insert(v->begin() + n / 2, T(i));
+    });
+    printf("%-22s %-10s %10.3f s %10.2f GB/s\n", name.c_str(), "mid_insert", second, shifted / second);
+    second = measure([&]() {
+        for (int i = 0; i < N_MID; ++i)
+            v->erase(v->begin() + n / 2);
+    });
+    printf("%-22s %-10s %10.3f s %10.2f GB/s\n", name.c_str(), "mid_erase", second, shifted / second);
+    const int N_BLOCK = 10, BLOCK_SIZE = 1000;
+    std::vector<T> block;
+    for (int i = 0; i < BLOCK_SIZE; ++i)
+        block.push_back(T(i));
+    report(name, "blk_insert", measure([&]() {
+               for (int i = 0; i < N_BLOCK; ++i)
+                   v->insert(v->begin() + n / 2, block.begin(), block.end());
+           }),
+           N_BLOCK * BLOCK_SIZE);
+    report(name, "blk_erase", measure([&]() {
+               for (int i = 0; i < N_BLOCK; ++i)
+                   v->erase(v->begin() + n / 2, v->begin() + n / 2 + BLOCK_SIZE);
+           }),
+           N_BLOCK * BLOCK_SIZE);
+    printf("%-22s %-10s %10.1f B/element, checksum %lld\n", name.c_str(), "memory", bytes, checksum);
+    delete v;
+}
+
+// build and drop n_request * 1000 vectors of 16 ints with allocators made by make
+template <class Vector, class Make, class Reset>
+void runShort(const std::string &name, Make make, Reset reset)
+{
+    const int N_VECTOR = 1000, N_ELEMENT = 16;
+    int n_request = std::max(1, config.n / 4 / N_VECTOR);
+    long long checksum = 0;
+    report(name, "request", measure([&]() {
+               for (int r = 0; r < n_request; ++r)
+               {
+                   for (int i = 0; i < N_VECTOR; ++i)
+                   {
+                       Vector v(make());
+                       for (int j = 0; j < N_ELEMENT; ++j)
+                           v.push_back(i + j);
+                       checksum += v[i % N_ELEMENT];
+                   }
+                   reset();
+               }
+           }),
+           (long long)n_request * N_VECTOR);
+    printf("%-22s %-10s %10lld\n", name.c_str(), "checksum", checksum);
+}
+
+void runMmap()
+{
+    const char *path = "mmap_vector.bin";
+    std::string name = "sjtu::mmap_vector<int>";
+    int n = config.n;
+    long long checksum = 0;
+    unlink(path);
+    {
+        sjtu::mmap_vector<int> v(path);
+        report(name, "push_back", measure([&]() {
+                   for (int i = 0; i < n; ++i)
+                       v.push_back(i);
+               }),
+               n);
+        report(name, "sync", measure([&]() { v.sync(); }), 1);
+    }
+    sjtu::mmap_vector<int> *v = nullptr;
+    report(name, "reopen", measure([&]() { v = new sjtu::mmap_vector<int>(path); }), 1);
+    report(name, "first_read", measure([&]() { checksum += (*v)[n / 2]; }), 1);
+    report(name, "seq_read", measure([&]() {
+               for (int i = 0; i < n; ++i)
+                   checksum += (*v)[i];
+           }),
+           n);
+    printf("%-22s %-10s %10zu elements, checksum %lld\n", name.c_str(), "size", v->size(), checksum);
+    delete v;
+    unlink(path);
+}
+
+// push_back(i) of config.n ints split over n_thread threads
+template <class F>
+double runThreads(int n_thread, F push_back)
+{
+    return measure([&]() {
+        std::vector<std::thread> threads;
+        int n = config.n / n_thread;
+        for (int t = 0; t < n_thread; ++t)
+            threads.emplace_back([&push_back, n, t]() {
+                for (int i = 0; i < n; ++i)
+                    push_back(t * n + i);
+            });
+        for (auto &thread : threads)
+            thread.join();
+    });
+}
+
+template <class Vector>
+void runLocked(const std::string &name, int n_thread)
+{
+    Vector v;
+    std::mutex mutex;
+    report(name, ("threads=" + std::to_string(n_thread)).c_str(), runThreads(n_thread, [&](int x) {
+               std::lock_guard<std::mutex> lock(mutex);
+               v.push_back(x);
+           }),
+           config.n);
+}
+
+void runConcurrent()
+{
+    for (int n_thread = 1; n_thread <= 32; n_thread <<= 1)
+    {
+        sjtu::segmented_vector<int> v;
+        report("sjtu::segmented_vector", ("threads=" + std::to_string(n_thread)).c_str(),
+               runThreads(n_thread, [&](int x) { v.push_back(x); }), config.n);
+        runLocked<std::vector<int>>("std::vector+mutex", n_thread);
+        runLocked<sjtu::vector<int>>("sjtu::vector+mutex", n_thread);
+    }
+}
+
+// NOTE: a parameter is never elided, so the return is a move or a copy
+template <class Vector>
+Vector relay(Vector v)
+{
+    return v;
+}
+
+template <class T, class Make>
+void runHeavy(const std::string &name, Make make)
+{
+    typedef sjtu::vector<T> Vector;
+    int n = std::max(1, config.n / 100);
+    Vector v;
+    report(name, "push_back", measure([&]() {
+               for (int i = 0; i < n; ++i)
+                   v.push_back(make(i));
+           }),
+           n);
+    int n_insert = std::max(1, n / 100);
+    report(name, "insert", measure([&]() {
+               for (int i = 0; i < n_insert; ++i)
+                   v.insert(0, make(i));
+           }),
+           n_insert);
+    report(name, "return", measure([&]() {
+               for (int i = 0; i < 10; ++i)
+                   v = relay(std::move(v));
+           }),
+           10);
+    printf("%-22s %-10s %10zu elements\n", name.c_str(), "size", v.size());
+}
+
+template <class T>
+void runSimd(const std::string &name)
+{
+    const int MAX_N = 100000000;
+    for (int n = 1000; n <= MAX_N; n *= 10)
+    {
+        sjtu::vector<T> v;
+        for (int i = 0; i < n; ++i)
+            v.push_back(T(i % 1000 + 1));
+        const sjtu::vector<T> &cv = v;
+        int n_repeat = MAX_N / n;
+        double gb = (double)sizeof(T) * n * n_repeat / 1e9;
+        double checksum = 0;
+        // seconds of n_repeat calls of f
+        auto time = [&](auto f) {
+            return measure([&]() {
+                for (int r = 0; r < n_repeat; ++r)
+                    checksum += f();
+            });
+        };
+        auto print = [&](const char *phase, double sjtu, double naive, double std) {
+            printf("%-22s %-10s %9d %9.2f sjtu %9.2f naive %9.2f std GB/s\n",
+                   name.c_str(), phase, n, gb / sjtu, gb / naive, gb / std);
+        };
+        print("find", time([&]() { return sjtu::find(cv, T(0)); }), time([&]() {
+                  int i = 0;
+                  while (i < n && cv[i] != T(0))
+                      i++;
+                  return i;
+              }),
+              time([&]() { return std::find(cv.cbegin(), cv.cend(), T(0)) - cv.cbegin(); }));
+        print("count", time([&]() { return sjtu::count(cv, T(0)); }), time([&]() {
+                  int ret = 0;
+                  for (int i = 0; i < n; ++i)
+                      ret += cv[i] == T(0);
+                  return ret;
+              }),
+              time([&]() { return std::count(cv.cbegin(), cv.cend(), T(0)); }));
+        print("min", time([&]() { return sjtu::min_value(cv); }), time([&]() {
+                  T ret = cv[0];
+                  for (int i = 1; i < n; ++i)
+                      if (cv[i] < ret)
+                          ret = cv[i];
+                  return ret;
+              }),
+              time([&]() { return *std::min_element(cv.cbegin(), cv.cend()); }));
+        print("max", time([&]() { return sjtu::max_value(cv); }), time([&]() {
+                  T ret = cv[0];
+                  for (int i = 1; i < n; ++i)
+                      if (ret < cv[i])
+                          ret = cv[i];
+                  return ret;
+              }),
+              time([&]() { return *std::max_element(cv.cbegin(), cv.cend()); }));
+        print("sum", time([&]() { return sjtu::sum(cv); }), time([&]() {
+                  typename sjtu::simd::sum_type<T>::type ret = 0;
+                  for (int i = 0; i < n; ++i)
+                      ret += cv[i];
+                  return ret;
+              }),
+              time([&]() {
+                  return std::accumulate(cv.cbegin(), cv.cend(), typename sjtu::simd::sum_type<T>::type(0));
+              }));
+        printf("%-22s %-10s %9d %10.0f\n", name.c_str(), "checksum", n, checksum);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i], value = argv[i + 1];
+        if (option == "-n")
+            config.n = atoi(value.c_str());
+        else if (option == "-s")
+            config.seed = atoi(value.c_str());
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(config.seed);
+    order.resize(config.n);
+    for (int i = 0; i < config.n; ++i)
+        order[i] = rng() % config.n;
+
+    run<sjtu::vector<int>, int>("sjtu::vector<int>");
+    run<std::vector<int>, int>("std::vector<int>");
+    run<sjtu::vector<Point>, Point>("sjtu::vector<Point>");
+    run<std::vector<Point>, Point>("std::vector<Point>");
+
+    auto make = []() { return std::allocator<int>(); };
+    runShort<std::vector<int>>("std::vector", make, []() {});
+    runShort<sjtu::vector<int>>("sjtu::vector", make, []() {});
+    {
+        sjtu::arena arena;
+        runShort<sjtu::vector<int, sjtu::arena_allocator<int>>>(
+            "sjtu::arena", [&]() { return sjtu::arena_allocator<int>(arena); }, [&]() { arena.reset(); });
+        printf("%-22s %-10s %10zu of %zu allocations\n", "sjtu::arena", "heap", arena.chunks(), arena.allocations());
+    }
+    {
+        sjtu::pool pool;
+        runShort<sjtu::vector<int, sjtu::pool_allocator<int>>>(
+            "sjtu::pool", [&]() { return sjtu::pool_allocator<int>(pool); }, []() {});
+        printf("%-22s %-10s %10zu of %zu allocations\n", "sjtu::pool", "heap", pool.heap_allocations(), pool.allocations());
+    }
+
+    runShort<sjtu::small_vector<int, 16>>("sjtu::small_vector", make, []() {});
+
+    runMmap();
+    runConcurrent();
+
+    runHeavy<Diamond::Matrix<int>>("sjtu::vector<Matrix>", [](int i) {
+        return Diamond::Matrix<int>(8, 8, i);
+    });
+    runHeavy<Util::Bint>("sjtu::vector<Bint>", [](int i) {
+        return Util::Bint(std::string(64, '1' + i % 9));
+    });
+
+    runSimd<int>("sjtu::vector<int>");
+    runSimd<long long>("sjtu::vector<long long>");
+    runSimd<double>("sjtu::vector<double>");
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "vector.hpp"
+#include "allocator.hpp"
+
+#include <iostream>
+#include <string>
+
+typedef sjtu::pool_allocator<std::string> PoolAllocator;
+typedef sjtu::arena_allocator<std::string> ArenaAllocator;
+typedef sjtu::vector<std::string, PoolAllocator> PoolVector;
+typedef sjtu::vector<std::string, ArenaAllocator> ArenaVector;
+typedef sjtu::vector<int, sjtu::arena_allocator<int>> ArenaIntVector;
+
+// a pool never propagates, so elements cross pools one by one
+void TestPool()
+{
+	std::cout << "Testing pool_allocator..." << std::endl;
+	sjtu::pool p1, p2;
+	{
+		PoolVector a{PoolAllocator(p1)}, b{PoolAllocator(p2)};
+		for (int i = 0; i < 1000; ++i) {
+			a.push_back(std::string(40, 'a' + i % 26));
+		}
+		b = a;
+		std::cout << b.size() << " " << (b.get_allocator() == PoolAllocator(p2)) << std::endl;
+		PoolVector c(std::move(a));
+		std::cout << a.size() << " " << c.size() << std::endl;
+		b = std::move(c);
+		std::cout << b.size() << " " << b[999] << " " << (b.get_allocator() == PoolAllocator(p2)) << std::endl;
+		PoolVector d(b);
+		for (int i = 0; i < 500; ++i) {
+			d.erase(0);
+			d.insert(d.size() / 2, "x");
+		}
+		std::cout << d.size() << " " << d[d.size() / 2] << " " << (d.get_allocator() == b.get_allocator()) << std::endl;
+	}
+	std::cout << p1.allocations() << " " << p1.recycled() << " " << p1.heap_allocations() << std::endl;
+}
+
+// an arena follows its memory on copy, move and swap
+void TestArena()
+{
+	std::cout << "Testing arena_allocator..." << std::endl;
+	sjtu::arena ar1, ar2;
+	{
+		ArenaVector a{ArenaAllocator(ar1)}, b{ArenaAllocator(ar2)};
+		for (int i = 0; i < 1000; ++i) {
+			a.push_back(std::to_string(i) + std::string(30, 'z'));
+		}
+		b = a;
+		std::cout << (b.get_allocator() == a.get_allocator()) << std::endl;
+		ArenaVector c{ArenaAllocator(ar2)};
+		c = std::move(b);
+		std::cout << c.size() << " " << (c.get_allocator() == a.get_allocator()) << std::endl;
+		ArenaIntVector x{sjtu::arena_allocator<int>(ar2)};
+		for (int i = 0; i < 100000; ++i) {
+			x.push_back(i);
+		}
+		for (int i = 0; i < 100; ++i) {
+			x.insert(5, i);
+			x.erase(7);
+		}
+		std::cout << x.size() << " " << x[5] << " " << x[99999] << std::endl;
+	}
+	std::cout << ar1.allocations() << " " << ar1.chunks() << std::endl;
+	// a reset arena stops allocating
+	for (int r = 0; r < 100; ++r) {
+		ArenaIntVector x{sjtu::arena_allocator<int>(ar2)};
+		for (int i = 0; i < 1000; ++i) {
+			x.push_back(i);
+		}
+		ar2.reset();
+	}
+	std::cout << ar2.allocations() << " " << ar2.chunks() << std::endl;
+}
+
+int main()
+{
+	TestPool();
+	TestArena();
+	return 0;
+}
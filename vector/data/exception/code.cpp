@@ -0,0 +1,168 @@
+#include "vector.hpp"
+
+#include <iostream>
+#include <vector>
+
+// an element whose copy (or move) constructor throws on the fail_at-th call
+int live = 0, n_call = 0, fail_at = -1;
+
+const int MAGIC = 0x5a5a;
+
+void tick()
+{
+	if (++n_call == fail_at)
+		throw 0;
+}
+
+class Fragile {
+public:
+	int value, magic;
+	Fragile(int value) : value(value), magic(MAGIC) { ++live; }
+	Fragile(const Fragile &other) : value(other.value), magic(MAGIC) { tick(); ++live; }
+	~Fragile() { magic = 0; --live; }
+};
+
+// move only, with a throwing move
+class FragileMove {
+public:
+	int value, magic;
+	FragileMove(int value) : value(value), magic(MAGIC) { ++live; }
+	FragileMove(const FragileMove &) = delete;
+	FragileMove(FragileMove &&other) : value(other.value), magic(MAGIC) { tick(); ++live; }
+	~FragileMove() { magic = 0; --live; }
+};
+
+template <class T>
+void fill(sjtu::vector<T> &v, int n)
+{
+	for (int i = 0; i < n; ++i)
+		v.emplace_back(i);
+}
+
+// every element alive, nothing leaked, and its values a prefix of expected
+//  (all of them if is_whole)
+template <class T>
+bool isValid(const sjtu::vector<T> &v, const std::vector<int> &expected, bool is_whole)
+{
+	if (live != (int)v.size() || v.size() > expected.size())
+		return false;
+	if (is_whole && v.size() != expected.size())
+		return false;
+	for (size_t i = 0; i < v.size(); ++i)
+		if (v[i].magic != MAGIC || v[i].value != expected[i])
+			return false;
+	return true;
+}
+
+// run op on a vector of 0 .. n - 1 with the k-th copy failing, for each k until none fails
+//  op updates expected before it touches v
+//  is_strong: a failed op leaves the vector unchanged, otherwise it keeps a prefix of the result
+template <class T, class Op>
+void run(const char *name, int n, Op op, bool is_strong)
+{
+	int n_throw = 0, n_broken = 0;
+	for (int k = 1;; ++k) {
+		std::vector<int> before, after;
+		bool is_thrown = false;
+		{
+			sjtu::vector<T> v;
+			fill(v, n);
+			for (int i = 0; i < n; ++i)
+				before.push_back(i);
+			after = before;
+			n_call = 0;
+			fail_at = k;
+			try {
+				op(v, after);
+			} catch (int) {
+				is_thrown = true;
+			}
+			fail_at = -1;
+			if (is_thrown) {
+				++n_throw;
+				if (!(is_strong ? isValid(v, before, true) : isValid(v, after, false)))
+					++n_broken;
+			} else if (!isValid(v, after, true)) {
+				++n_broken;
+			}
+		}
+		if (live != 0)
+			++n_broken;
+		live = 0;
+		if (!is_thrown)
+			break;
+	}
+	std::cout << name << ": " << n_throw << " throws, " << n_broken << " broken" << std::endl;
+}
+
+template <class T>
+void insertMiddle(sjtu::vector<T> &v, std::vector<int> &expected)
+{
+	v.insert(v.begin() + 5, T(-1));
+	expected.insert(expected.begin() + 5, -1);
+}
+
+template <class T>
+void emplaceMiddle(sjtu::vector<T> &v, std::vector<int> &expected)
+{
+	v.emplace(v.begin() + 3, -2);
+	expected.insert(expected.begin() + 3, -2);
+}
+
+template <class T>
+void eraseMiddle(sjtu::vector<T> &v, std::vector<int> &expected)
+{
+	expected.erase(expected.begin() + 4);
+	v.erase(4);
+}
+
+template <class T>
+void eraseRange(sjtu::vector<T> &v, std::vector<int> &expected)
+{
+	expected.erase(expected.begin() + 2, expected.begin() + 5);
+	v.erase(v.begin() + 2, v.begin() + 5);
+}
+
+int main()
+{
+	// 12 elements in a buffer of 16, so inserts do not grow
+	run<Fragile>("push_back", 12, [](sjtu::vector<Fragile> &v, std::vector<int> &e) {
+		Fragile x(-3);
+		v.push_back(x);
+		e.push_back(-3);
+	}, true);
+	run<Fragile>("push_back of an element", 16, [](sjtu::vector<Fragile> &v, std::vector<int> &e) {
+		v.push_back(v[1]);
+		e.push_back(1);
+	}, true);
+	run<Fragile>("insert", 12, insertMiddle<Fragile>, true);
+	run<Fragile>("insert of an element", 12, [](sjtu::vector<Fragile> &v, std::vector<int> &e) {
+		v.insert(2, v[7]);
+		e.insert(e.begin() + 2, 7);
+	}, true);
+	run<Fragile>("emplace", 12, emplaceMiddle<Fragile>, true);
+	run<Fragile>("insert count", 12, [](sjtu::vector<Fragile> &v, std::vector<int> &e) {
+		v.insert(v.begin() + 6, 3, Fragile(-4));
+		e.insert(e.begin() + 6, 3, -4);
+	}, true);
+	run<Fragile>("erase", 12, eraseMiddle<Fragile>, false);
+	run<Fragile>("erase range", 12, eraseRange<Fragile>, false);
+	run<Fragile>("copy assignment", 12, [](sjtu::vector<Fragile> &v, std::vector<int> &e) {
+		sjtu::vector<Fragile> w;
+		fill(w, 20);
+		v = w;
+		e.clear();
+		for (int i = 0; i < 20; ++i)
+			e.push_back(i);
+	}, true);
+	// 16 elements in a buffer of 16, so the buffer grows by moves
+	run<FragileMove>("move only push_back growing", 16, [](sjtu::vector<FragileMove> &v, std::vector<int> &e) {
+		e.push_back(-5);
+		v.emplace_back(-5);
+	}, false);
+	run<FragileMove>("move only insert", 12, insertMiddle<FragileMove>, false);
+	run<FragileMove>("move only emplace", 12, emplaceMiddle<FragileMove>, false);
+	run<FragileMove>("move only erase", 12, eraseMiddle<FragileMove>, false);
+	run<FragileMove>("move only erase range", 12, eraseRange<FragileMove>, false);
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include "vector.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+
+// std:: algorithms over the iterators, which are pointers unless SJTU_VECTOR_CHECKED
+//  the output is the same in both modes
+void TestAlgorithms()
+{
+	std::cout << "Testing std:: algorithms..." << std::endl;
+	static_assert(std::is_same<std::iterator_traits<sjtu::vector<int>::iterator>::iterator_category,
+	                           std::random_access_iterator_tag>::value, "random access");
+	std::mt19937 rng(2);
+	sjtu::vector<int> v;
+	for (int i = 0; i < 100000; ++i) {
+		v.push_back(rng() % 1000000);
+	}
+	std::sort(v.begin(), v.end());
+	std::cout << std::is_sorted(v.begin(), v.end()) << " " << v.front() << " " << v.back() << std::endl;
+	sjtu::vector<int>::iterator it = std::lower_bound(v.begin(), v.end(), 500000);
+	std::cout << (it - v.begin()) << " " << *it << " " << it[1] << std::endl;
+	std::cout << std::accumulate(v.begin(), v.end(), 0LL) << std::endl;
+	std::reverse(v.begin(), v.end());
+	const sjtu::vector<int> &cv = v;
+	std::cout << *std::max_element(cv.cbegin(), cv.cend()) << " "
+	          << std::count_if(cv.cbegin(), cv.cend(), [](int x) { return x % 2 == 0; }) << std::endl;
+}
+
+// ordering, arithmetic and ->
+void TestOperators()
+{
+	std::cout << "Testing iterator operators..." << std::endl;
+	sjtu::vector<std::string> v;
+	for (int i = 0; i < 10; ++i) {
+		v.push_back(std::string(i + 1, 'a' + i));
+	}
+	sjtu::vector<std::string>::iterator a = v.begin() + 2, b = v.end() - 3;
+	std::cout << (a < b) << (a > b) << (a <= a) << (b >= a) << (a == b) << (a != b) << " "
+	          << (b - a) << " " << a->size() << " " << b[-1] << std::endl;
+	a += 4;
+	--b;
+	std::cout << (a == b) << " " << *a << std::endl;
+	sjtu::vector<std::string>::const_iterator c = v.cbegin();
+	c++;
+	std::cout << c->size() << " " << *(c + 8) << std::endl;
+}
+
+// at() and the indexes of insert / erase are checked in both modes
+void TestBounds()
+{
+	std::cout << "Testing bounds..." << std::endl;
+	sjtu::vector<int> v;
+	for (int i = 0; i < 5; ++i) {
+		v.push_back(i);
+	}
+	int n_thrown = 0;
+	try {
+		v.at(5);
+	} catch (sjtu::index_out_of_bound &) {
+		++n_thrown;
+	}
+	try {
+		v.insert(6, 1);
+	} catch (sjtu::index_out_of_bound &) {
+		++n_thrown;
+	}
+	try {
+		v.erase(5);
+	} catch (sjtu::index_out_of_bound &) {
+		++n_thrown;
+	}
+	std::cout << n_thrown << " " << v.size() << std::endl;
+}
+
+int main()
+{
+	TestAlgorithms();
+	TestOperators();
+	TestBounds();
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include "mmap_vector.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <vector>
+
+const char *PATH = "mmap_vector.bin";
+
+// a type of another size, whose file is refused
+struct Pair {
+	int a;
+	double b;
+};
+
+template <class V>
+bool isSame(const V &a, const std::vector<int> &b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < b.size(); ++i) {
+		if (a[i] != b[i])
+			return false;
+	}
+	return true;
+}
+
+std::vector<int> ref;
+
+// random modifications against std::vector, growing the file many times
+void TestModify()
+{
+	std::cout << "Testing modifiers..." << std::endl;
+	std::mt19937 rng(3);
+	sjtu::mmap_vector<int> v(PATH);
+	std::cout << v.empty() << std::endl;
+	for (int step = 0; step < 20000; ++step) {
+		int op = rng() % 7, n = v.size();
+		if (op <= 2) {
+			v.push_back(step);
+			ref.push_back(step);
+		} else if (op == 3) {
+			// an element of itself, which may move with the growth
+			int ind = rng() % (n + 1);
+			v.insert(ind, n > 0 ? v[0] : 1);
+			ref.insert(ref.begin() + ind, n > 0 ? ref[0] : 1);
+		} else if (op == 4 && n > 0) {
+			int l = rng() % n, r = l + rng() % std::min(20, n - l + 1);
+			v.erase(v.begin() + l, v.begin() + r);
+			ref.erase(ref.begin() + l, ref.begin() + r);
+		} else if (op == 5) {
+			int ind = rng() % (n + 1);
+			std::vector<int> src(rng() % 50, step);
+			v.insert(v.begin() + ind, src.begin(), src.end());
+			ref.insert(ref.begin() + ind, src.begin(), src.end());
+		} else if (op == 6 && n > 0) {
+			int ind = rng() % n;
+			v.erase(ind);
+			ref.erase(ref.begin() + ind);
+		}
+	}
+	v.insert(v.begin() + 1, (size_t)3, 7);
+	ref.insert(ref.begin() + 1, 3, 7);
+	std::istringstream in("5 6");
+	v.insert(v.end(), std::istream_iterator<int>(in), std::istream_iterator<int>());
+	ref.push_back(5);
+	ref.push_back(6);
+	v.sync();
+	std::cout << v.size() << " " << v.capacity() << " " << isSame(v, ref) << std::endl;
+	try {
+		v.at(v.size());
+	} catch (sjtu::index_out_of_bound &) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+}
+
+// the elements survive the process, and a read only one refuses to change
+void TestReopen()
+{
+	std::cout << "Testing reopen..." << std::endl;
+	sjtu::mmap_vector<int> v(PATH, true);
+	long long sum = 0;
+	for (const int *p = v.cbegin(); p != v.cend(); ++p) {
+		sum += *p;
+	}
+	std::cout << isSame(v, ref) << " " << sum << std::endl;
+	try {
+		v.push_back(1);
+	} catch (sjtu::runtime_error &) {
+		std::cout << "read only refused" << std::endl;
+	}
+}
+
+void TestRefuse()
+{
+	std::cout << "Testing bad files..." << std::endl;
+	try {
+		sjtu::mmap_vector<Pair> w(PATH);
+	} catch (sjtu::runtime_error &) {
+		std::cout << "type mismatch refused" << std::endl;
+	}
+	try {
+		sjtu::mmap_vector<int> w("mmap_vector.none", true);
+	} catch (sjtu::runtime_error &) {
+		std::cout << "missing read only refused" << std::endl;
+	}
+	const char *junk = "mmap_vector.junk";
+	FILE *f = fopen(junk, "w");
+	for (int i = 0; i < 5000; ++i) {
+		fputc('x', f);
+	}
+	fclose(f);
+	try {
+		sjtu::mmap_vector<int> w(junk);
+	} catch (sjtu::runtime_error &) {
+		std::cout << "junk refused" << std::endl;
+	}
+	remove(junk);
+	// a header whose size is far beyond the file
+	const char *huge = "mmap_vector.huge";
+	{
+		sjtu::mmap_vector<int> w(huge);
+		w.push_back(1);
+	}
+	f = fopen(huge, "r+b");
+	long long size = 1LL << 62;
+	fseek(f, 16, SEEK_SET);
+	fwrite(&size, sizeof(size), 1, f);
+	fclose(f);
+	try {
+		sjtu::mmap_vector<int> w(huge);
+		std::cout << w.back() << std::endl;
+	} catch (sjtu::runtime_error &) {
+		std::cout << "huge size refused" << std::endl;
+	}
+	remove(huge);
+}
+
+void TestClear()
+{
+	std::cout << "Testing clear and assign..." << std::endl;
+	sjtu::mmap_vector<int> v(PATH);
+	v.clear();
+	v.emplace_back(4);
+	v.pop_back();
+	std::cout << v.empty() << std::endl;
+	try {
+		v.pop_back();
+	} catch (sjtu::container_is_empty &) {
+		std::cout << "container_is_empty" << std::endl;
+	}
+	std::vector<int> src(100, 2);
+	v.assign(src.begin(), src.end());
+	std::cout << isSame(v, src) << std::endl;
+}
+
+int main()
+{
+	remove(PATH);
+	TestModify();
+	TestReopen();
+	TestRefuse();
+	TestClear();
+	remove(PATH);
+	return 0;
+}
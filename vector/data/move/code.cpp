@@ -0,0 +1,71 @@
+#include "vector.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+class Person {
+public:
+	int id;
+	std::string name;
+	Person(int id, const std::string &name) : id(id), name(name) {}
+};
+
+void TestMoveOnly()
+{
+	std::cout << "Testing move only elements..." << std::endl;
+	sjtu::vector<std::unique_ptr<int>> v;
+	for (int i = 0; i < 100; ++i) {
+		v.push_back(std::unique_ptr<int>(new int(i)));
+	}
+	v.emplace(v.begin() + 3, new int(-1));
+	v.insert(0, std::unique_ptr<int>(new int(-2)));
+	v.insert(v.begin() + 50, std::unique_ptr<int>(new int(-3)));
+	v.erase(5);
+	v.emplace_back();
+	std::cout << v.size() << " " << *v[0] << " " << *v[4] << " " << *v[5] << " " << *v[50] << " "
+	          << (v.back() == nullptr) << std::endl;
+}
+
+void TestMoveConstructor()
+{
+	std::cout << "Testing move constructor and assignment..." << std::endl;
+	sjtu::vector<std::string> v;
+	for (int i = 0; i < 10; ++i) {
+		v.push_back(std::string(20, 'a' + i));
+	}
+	sjtu::vector<std::string> w(std::move(v));
+	std::cout << v.size() << " " << w.size() << " " << w[9] << std::endl;
+	v = std::move(w);
+	std::cout << v.size() << " " << w.size() << " " << v[0] << std::endl;
+	w.push_back("reused");
+	std::cout << w.size() << " " << w[0] << std::endl;
+}
+
+void TestEmplace()
+{
+	std::cout << "Testing emplace..." << std::endl;
+	sjtu::vector<Person> v;
+	for (int i = 0; i < 50; ++i) {
+		Person &p = v.emplace_back(i, std::to_string(i));
+		p.id *= 2;
+	}
+	// arguments referring to elements which are shifted or reallocated
+	v.emplace(v.begin(), v[10].id, v[10].name);
+	v.emplace_back(v[0]);
+	v.push_back(v[25]);
+	v.insert(v.begin() + 1, v.back());
+	for (size_t i = 0; i < 3; ++i) {
+		std::cout << v[i].id << ":" << v[i].name << " ";
+	}
+	std::cout << v[v.size() - 2].id << ":" << v[v.size() - 2].name << " ";
+	std::cout << v.back().id << ":" << v.back().name << std::endl;
+}
+
+int main()
+{
+	TestMoveOnly();
+	TestMoveConstructor();
+	TestEmplace();
+	return 0;
+}
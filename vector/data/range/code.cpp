@@ -0,0 +1,198 @@
+#include "vector.hpp"
+#include "small_vector.hpp"
+
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+std::mt19937 rng(7);
+
+template <class V, class T>
+bool isSame(const V &a, const std::vector<T> &b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < b.size(); ++i) {
+		if (!(a[i] == b[i]))
+			return false;
+	}
+	return true;
+}
+
+template <class V>
+void print(const V &v)
+{
+	for (size_t i = 0; i < v.size(); ++i) {
+		std::cout << v[i] << " ";
+	}
+	std::cout << std::endl;
+}
+
+// random range inserts, erases and assigns against std::vector
+template <class V, class T, class Make>
+void fuzz(const char *name, Make make)
+{
+	V a;
+	std::vector<T> b;
+	int n_mismatch = 0;
+	for (int step = 0; step < 3000; ++step) {
+		int op = rng() % 6, n = a.size();
+		if (op == 0) {
+			int ind = rng() % (n + 1), k = rng() % 20;
+			std::vector<T> src;
+			for (int i = 0; i < k; ++i) {
+				src.push_back(make(rng()));
+			}
+			a.insert(a.begin() + ind, src.begin(), src.end());
+			b.insert(b.begin() + ind, src.begin(), src.end());
+		} else if (op == 1 && n > 0) {
+			// copies of an element of itself
+			int ind = rng() % (n + 1), k = rng() % 5, j = rng() % n;
+			T value = b[j];
+			a.insert(a.begin() + ind, (size_t)k, a[j]);
+			b.insert(b.begin() + ind, k, value);
+		} else if (op == 2 && n > 0) {
+			int l = rng() % n, r = l + rng() % (n - l + 1);
+			if (r - l > 30)
+				r = l + 30;
+			a.erase(a.begin() + l, a.begin() + r);
+			b.erase(b.begin() + l, b.begin() + r);
+		} else if (op == 3 && rng() % 20 == 0) {
+			int k = rng() % 40;
+			std::vector<T> src;
+			for (int i = 0; i < k; ++i) {
+				src.push_back(make(rng()));
+			}
+			a.assign(src.begin(), src.end());
+			b.assign(src.begin(), src.end());
+		} else if (op == 4) {
+			a.push_back(make(step));
+			b.push_back(make(step));
+		} else if (op == 5 && n > 0) {
+			int ind = rng() % n;
+			a.erase(ind);
+			b.erase(b.begin() + ind);
+		}
+		n_mismatch += !isSame(a, b);
+	}
+	std::cout << name << ": " << a.size() << " " << n_mismatch << std::endl;
+}
+
+std::string makeString(int x)
+{
+	return std::to_string(x) + std::string(20, 'x');
+}
+
+// a single pass range is collected first
+void TestInputIterator()
+{
+	std::cout << "Testing input iterators..." << std::endl;
+	sjtu::vector<int> a;
+	for (int i = 0; i < 5; ++i) {
+		a.push_back(i);
+	}
+	std::istringstream in("10 11 12");
+	a.insert(a.begin() + 2, std::istream_iterator<int>(in), std::istream_iterator<int>());
+	print(a);
+	std::istringstream in2("7 8");
+	a.assign(std::istream_iterator<int>(in2), std::istream_iterator<int>());
+	print(a);
+	a.insert(a.begin(), (size_t)3, 1);
+	print(a);
+}
+
+int live = 0, budget = -1, n_copy = 0;
+
+// an element whose copy throws once budget copies are spent
+class Thrower {
+public:
+	std::string s;
+	Thrower(const std::string &s) : s(s) { ++live; }
+	Thrower(const Thrower &other) : s(other.s)
+	{
+		if (budget == 0)
+			throw 0;
+		if (budget > 0)
+			--budget;
+		++live;
+		++n_copy;
+	}
+	~Thrower() { --live; }
+};
+
+// a range insert which throws leaves the vector unchanged
+void TestException()
+{
+	std::cout << "Testing exceptions of range insert..." << std::endl;
+	int n_throw = 0, n_broken = 0;
+	for (int trial = 0; trial < 400; ++trial) {
+		{
+			sjtu::vector<Thrower> v;
+			std::vector<std::string> ref;
+			int n = rng() % 12;
+			for (int i = 0; i < n; ++i) {
+				v.push_back(Thrower(std::to_string(i)));
+				ref.push_back(std::to_string(i));
+			}
+			std::vector<Thrower> src;
+			for (int i = 0; i < 5; ++i) {
+				src.push_back(Thrower("s" + std::to_string(i)));
+			}
+			budget = rng() % 12;
+			int ind = rng() % (n + 1);
+			try {
+				v.insert(v.begin() + ind, src.begin(), src.end());
+				for (int i = 4; i >= 0; --i) {
+					ref.insert(ref.begin() + ind, "s" + std::to_string(i));
+				}
+			} catch (int) {
+				++n_throw;
+			}
+			budget = -1;
+			bool is_same = v.size() == ref.size();
+			for (size_t i = 0; is_same && i < ref.size(); ++i) {
+				is_same = v[i].s == ref[i];
+			}
+			n_broken += !is_same;
+		}
+		n_broken += live != 0;
+		live = 0;
+	}
+	std::cout << n_throw << " throws, " << n_broken << " broken" << std::endl;
+}
+
+// appending a range copies only the new elements, unless the buffer grows
+void TestAppend()
+{
+	std::cout << "Testing copies of appends..." << std::endl;
+	std::vector<Thrower> src(5, Thrower("a"));
+	{
+		sjtu::vector<Thrower> v;
+		n_copy = 0;
+		for (int i = 0; i < 1000; ++i) {
+			v.insert(v.end(), src.begin(), src.begin() + 1);
+		}
+		// 1000 new elements, and 1 + 2 + ... + 512 moved by 10 growths
+		std::cout << v.size() << " elements, " << n_copy << " copies" << std::endl;
+		n_copy = 0;
+		for (int i = 0; i < 100; ++i) {
+			v.assign(src.begin(), src.end());
+		}
+		std::cout << v.size() << " elements, " << n_copy << " copies" << std::endl;
+	}
+	live = 0;
+}
+
+int main()
+{
+	fuzz<sjtu::vector<int>, int>("vector<int>", [](int x) { return x; });
+	fuzz<sjtu::vector<std::string>, std::string>("vector<string>", makeString);
+	fuzz<sjtu::small_vector<std::string, 8>, std::string>("small_vector<string, 8>", makeString);
+	TestInputIterator();
+	TestException();
+	TestAppend();
+	return 0;
+}
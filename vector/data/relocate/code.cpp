@@ -0,0 +1,65 @@
+#include "vector.hpp"
+
+#include "class-bint.hpp"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Bint owns its digits through a pointer, so it can be moved by memmove
+namespace sjtu
+{
+	template <>
+	struct is_trivially_relocatable<Util::Bint> : std::true_type {};
+}
+
+// random inserts and erases in the middle, against std::vector
+void TestRelocate()
+{
+	std::cout << "Testing relocation..." << std::endl;
+	std::mt19937 rng(1);
+	sjtu::vector<int> a;
+	std::vector<int> ref_a;
+	sjtu::vector<Util::Bint> b;
+	std::vector<long long> ref_b;
+	for (int i = 0; i < 20000; ++i) {
+		if (rng() % 3 < 2 || ref_a.empty()) {
+			size_t k = rng() % (ref_a.size() + 1);
+			a.insert(k, i);
+			ref_a.insert(ref_a.begin() + k, i);
+			b.insert(k, Util::Bint(i));
+			ref_b.insert(ref_b.begin() + k, i);
+			if (rng() % 7 == 0) {
+				// an element of itself, which may be relocated by the growth
+				size_t j = rng() % b.size();
+				b.push_back(b[j]);
+				ref_b.push_back(ref_b[j]);
+				b[b.size() - 1] = b[0];
+				ref_b.back() = ref_b[0];
+			}
+		} else {
+			size_t k = rng() % ref_a.size();
+			a.erase(k);
+			ref_a.erase(ref_a.begin() + k);
+			b.erase(k);
+			ref_b.erase(ref_b.begin() + k);
+		}
+	}
+	int n_mismatch = 0;
+	for (size_t i = 0; i < ref_a.size(); ++i) {
+		n_mismatch += !(a[i] == ref_a[i]);
+	}
+	for (size_t i = 0; i < ref_b.size(); ++i) {
+		n_mismatch += !(b[i] == Util::Bint(ref_b[i]));
+	}
+	std::cout << a.size() << " " << b.size() << " " << n_mismatch << std::endl;
+	sjtu::vector<Util::Bint> c(b);
+	b.clear();
+	std::cout << c.size() << " " << c[c.size() / 2] << " " << c.back() << std::endl;
+}
+
+int main()
+{
+	TestRelocate();
+	return 0;
+}
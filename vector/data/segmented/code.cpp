@@ -0,0 +1,164 @@
+#include "segmented_vector.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// operator new fails once armed, to fail the allocation of a segment
+bool is_new_armed = false;
+
+void *operator new(size_t n)
+{
+	if (is_new_armed) {
+		is_new_armed = false;
+		throw std::bad_alloc();
+	}
+	void *p = malloc(n == 0 ? 1 : n);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+int live = 0;
+
+// an element whose constructor from an int throws for negative ones
+class Element {
+public:
+	int value;
+	Element(int value) : value(value)
+	{
+		if (value < 0)
+			throw 0;
+		++live;
+	}
+	Element(const Element &other) noexcept : value(other.value) { ++live; }
+	~Element() { --live; }
+};
+
+void TestStable()
+{
+	std::cout << "Testing stable references..." << std::endl;
+	sjtu::segmented_vector<std::string> v;
+	std::vector<std::string *> refs;
+	for (int i = 0; i < 5000; ++i) {
+		v.push_back(std::to_string(i));
+		refs.push_back(&v[i]);
+	}
+	int n_moved = 0;
+	for (int i = 0; i < 5000; ++i) {
+		n_moved += refs[i] != &v[i] || *refs[i] != std::to_string(i);
+	}
+	std::cout << n_moved << " " << (v.end() - v.begin()) << " " << v.back() << std::endl;
+	std::string &e = v.emplace_back(3, 'z');
+	std::cout << (&e == &v[5000]) << " " << e << std::endl;
+	v.pop_back();
+	try {
+		v.at(5000);
+	} catch (sjtu::index_out_of_bound &) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	v.clear();
+	v.push_back("a");
+	std::cout << v.size() << " " << v[0] << std::endl;
+}
+
+void TestIterator()
+{
+	std::cout << "Testing iterators..." << std::endl;
+	sjtu::segmented_vector<int> v;
+	for (int i = 0; i < 100; ++i) {
+		v.push_back(99 - i);
+	}
+	std::sort(v.begin(), v.end());
+	std::cout << std::is_sorted(v.cbegin(), v.cend()) << " " << v.front() << " " << v.back() << std::endl;
+	sjtu::segmented_vector<int>::iterator a = v.begin() + 10, b = v.end() - 10;
+	sjtu::segmented_vector<int>::const_iterator c = a;
+	std::cout << (a < b) << (a > b) << (a <= a) << (b >= a) << (c == a) << " " << (b - a) << " " << a[5]
+	          << std::endl;
+}
+
+// a failed constructor or segment allocation leaves no hole
+void TestFailure()
+{
+	std::cout << "Testing failures..." << std::endl;
+	{
+		sjtu::segmented_vector<Element> v;
+		int n_thrown = 0;
+		size_t failed_size = 0;
+		for (int i = 0; i < 200; ++i) {
+			try {
+				// 32 and 96 elements fill the first segments, whose next allocation fails once
+				is_new_armed = (v.size() == 32 || v.size() == 96) && v.size() != failed_size;
+				v.emplace_back(i % 7 == 3 ? -1 : i);
+			} catch (int) {
+				++n_thrown;
+			} catch (std::bad_alloc &) {
+				++n_thrown;
+				failed_size = v.size();
+			}
+			is_new_armed = false;
+		}
+		int n_bad = live != (int)v.size();
+		for (size_t i = 0; i < v.size(); ++i) {
+			n_bad += v[i].value < 0;
+		}
+		std::cout << n_thrown << " " << v.size() << " " << n_bad << std::endl;
+	}
+	std::cout << live << std::endl;
+}
+
+// every index returned by a concurrent push_back holds its value, and none is lost
+void TestConcurrent()
+{
+	std::cout << "Testing concurrent push_back..." << std::endl;
+	const int N_PER_THREAD = 20000;
+	for (int n_thread : {1, 2, 4, 8, 32}) {
+		sjtu::segmented_vector<long long> v;
+		std::vector<std::thread> threads;
+		std::vector<int> n_wrong(n_thread, 0);
+		for (int t = 0; t < n_thread; ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < N_PER_THREAD; ++i) {
+					long long x = (long long)t * N_PER_THREAD + i;
+					n_wrong[t] += v[v.push_back(x)] != x;
+				}
+			});
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+		std::vector<long long> all(v.begin(), v.end());
+		std::sort(all.begin(), all.end());
+		int n_bad = 0;
+		for (size_t i = 0; i < all.size(); ++i) {
+			n_bad += all[i] != (long long)i;
+		}
+		for (int t = 0; t < n_thread; ++t) {
+			n_bad += n_wrong[t];
+		}
+		std::cout << n_thread << " " << v.size() << " " << n_bad << std::endl;
+	}
+}
+
+int main()
+{
+	TestStable();
+	TestIterator();
+	TestFailure();
+	TestConcurrent();
+	return 0;
+}
@@ -0,0 +1,104 @@
+#include "vector.hpp"
+#include "simd.hpp"
+#include "small_vector.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// the kernels against std:: algorithms, for every length up to 300,
+//  so that the AVX2 blocks and the plain remainder are both covered
+template <class T>
+void fuzz(const char *name, int range)
+{
+	std::mt19937 rng(1);
+	int n_mismatch = 0, n_thrown = 0;
+	for (int n = 0; n < 300; ++n) {
+		for (int round = 0; round < 5; ++round) {
+			sjtu::vector<T> v;
+			std::vector<T> ref;
+			for (int i = 0; i < n; ++i) {
+				T x = (T)((long long)(rng() % range) - range / 2);
+				v.push_back(x);
+				ref.push_back(x);
+			}
+			for (int q = 0; q < 5; ++q) {
+				T x = (T)((long long)(rng() % range) - range / 2);
+				size_t pos = std::find(ref.begin(), ref.end(), x) - ref.begin();
+				n_mismatch += sjtu::find(v, x) != pos;
+				n_mismatch += sjtu::contains(v, x) != (pos != ref.size());
+				n_mismatch += sjtu::count(v, x) != (size_t)std::count(ref.begin(), ref.end(), x);
+			}
+			if (n == 0) {
+				try {
+					sjtu::min_value(v);
+				} catch (sjtu::container_is_empty &) {
+					++n_thrown;
+				}
+				continue;
+			}
+			n_mismatch += sjtu::min_value(v) != *std::min_element(ref.begin(), ref.end());
+			n_mismatch += sjtu::max_value(v) != *std::max_element(ref.begin(), ref.end());
+			n_mismatch += sjtu::sum(v) != std::accumulate(ref.begin(), ref.end(),
+			                                              (typename sjtu::simd::sum_type<T>::type)0);
+		}
+	}
+	std::cout << name << ": " << n_mismatch << " mismatches, " << n_thrown << " empty" << std::endl;
+}
+
+// plain literals convert to the element type
+void TestLiterals()
+{
+	std::cout << "Testing literals..." << std::endl;
+	sjtu::vector<long long> a;
+	sjtu::vector<double> b;
+	sjtu::vector<int> c;
+	for (int i = 0; i < 100; ++i) {
+		a.push_back(i % 10);
+		b.push_back(i % 4 * 0.5);
+		c.push_back(i);
+	}
+	std::cout << sjtu::find(a, 5) << " " << sjtu::count(a, 5) << " " << sjtu::contains(a, 10) << std::endl;
+	std::cout << sjtu::find(b, 1) << " " << sjtu::count(b, 0) << " " << sjtu::contains(b, 0.5f) << std::endl;
+	std::cout << sjtu::find(c, 'a') << " " << sjtu::count(c, 7LL) << " " << sjtu::contains(c, 99u) << std::endl;
+}
+
+// extremes, overflow of int into the long long sum, and a small_vector
+void TestEdges()
+{
+	std::cout << "Testing edges..." << std::endl;
+	sjtu::vector<int> big;
+	for (int i = 0; i < 1000; ++i) {
+		big.push_back(i == 777 ? INT_MIN : (i == 333 ? INT_MAX : 2000000000));
+	}
+	std::cout << sjtu::min_value(big) << " " << sjtu::max_value(big) << " " << sjtu::sum(big) << std::endl;
+	sjtu::vector<long long> wide;
+	for (int i = 0; i < 100; ++i) {
+		wide.push_back(-(1LL << 60) + i);
+	}
+	std::cout << sjtu::min_value(wide) << " " << sjtu::max_value(wide) << std::endl;
+	sjtu::small_vector<int, 16> small;
+	for (int i = 0; i < 10; ++i) {
+		small.push_back(i);
+	}
+	std::cout << sjtu::find(small, 7) << " " << sjtu::sum(small) << std::endl;
+	const sjtu::vector<double> empty;
+	std::cout << sjtu::sum(empty) << " " << sjtu::contains(empty, 0) << " " << sjtu::find(empty, 0) << std::endl;
+}
+
+int main()
+{
+	fuzz<int>("int", 50);
+	fuzz<int>("int of a wide range", 2000000000);
+	fuzz<long long>("long long", 50);
+	fuzz<double>("double", 50);
+	fuzz<short>("short", 50);
+	fuzz<unsigned>("unsigned", 50);
+	fuzz<float>("float", 50);
+	TestLiterals();
+	TestEdges();
+	return 0;
+}
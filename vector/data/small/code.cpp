@@ -0,0 +1,128 @@
+#include "small_vector.hpp"
+#include "allocator.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef sjtu::small_vector<std::string, 4> SmallVector;
+typedef sjtu::vector<std::string> Vector;
+
+int n_mismatch = 0;
+
+template <class V>
+void check(const V &v, const std::vector<std::string> &expected)
+{
+	bool is_same = v.size() == expected.size();
+	for (size_t i = 0; is_same && i < expected.size(); ++i) {
+		is_same = v[i] == expected[i];
+	}
+	n_mismatch += !is_same;
+}
+
+std::string make(int i)
+{
+	return std::string(20 + i % 7, 'a' + i % 26);
+}
+
+size_t totalLength(Vector &v)
+{
+	size_t ret = 0;
+	for (Vector::iterator it = v.begin(); it != v.end(); ++it) {
+		ret += (*it).size();
+	}
+	return ret;
+}
+
+// copies and moves between small vectors, inline or spilled, and plain vectors
+void TestConversions()
+{
+	std::cout << "Testing small_vector..." << std::endl;
+	std::mt19937 rng(1);
+	int n_inline = 0;
+	size_t length = 0;
+	for (int round = 0; round < 2000; ++round) {
+		SmallVector a;
+		std::vector<std::string> ref;
+		int n = rng() % 10;
+		for (int i = 0; i < n; ++i) {
+			a.push_back(make(i));
+			ref.push_back(make(i));
+		}
+		n_inline += a.is_inline();
+		n_mismatch += a.is_inline() != (n <= 4);
+		check(a, ref);
+		SmallVector b(a);
+		check(b, ref);
+		SmallVector c(std::move(b));
+		check(c, ref);
+		n_mismatch += b.size() != 0;
+		b.push_back("x");
+		Vector plain(std::move(c));
+		check(plain, ref);
+		n_mismatch += !c.is_inline();
+		SmallVector d(plain);
+		check(d, ref);
+		SmallVector e(std::move(plain));
+		check(e, ref);
+		SmallVector f;
+		f.push_back("q");
+		f = e;
+		check(f, ref);
+		SmallVector g;
+		for (int i = 0; i < 6; ++i) {
+			g.push_back("z");
+		}
+		g = std::move(f);
+		check(g, ref);
+		length += totalLength(g);
+		Vector h;
+		h.push_back("a");
+		h = a;
+		check(h, ref);
+		Vector k;
+		k = std::move(a);
+		check(k, ref);
+		if (n > 0) {
+			g.erase(0);
+			ref.erase(ref.begin());
+			g.insert(g.size() / 2, make(99));
+			ref.insert(ref.begin() + ref.size() / 2, make(99));
+			check(g, ref);
+		}
+		g.emplace_back(3, 'c');
+		ref.emplace_back(3, 'c');
+		check(g, ref);
+		g.pop_back();
+		ref.pop_back();
+		check(g, ref);
+	}
+	std::cout << n_inline << " " << length << " " << n_mismatch << std::endl;
+}
+
+// a pool never propagates, even from an inline buffer
+void TestPool()
+{
+	std::cout << "Testing small_vector with a pool..." << std::endl;
+	typedef sjtu::pool_allocator<std::string> PoolAllocator;
+	typedef sjtu::small_vector<std::string, 2, PoolAllocator> PoolVector;
+	sjtu::pool p1, p2;
+	PoolVector a{PoolAllocator(p1)}, b{PoolAllocator(p2)};
+	for (int i = 0; i < 3; ++i) {
+		a.push_back(make(i));
+	}
+	b = std::move(a);
+	std::cout << b.size() << " " << (b.get_allocator() == PoolAllocator(p2)) << std::endl;
+	PoolVector c{PoolAllocator(p1)};
+	c.push_back("1");
+	c = std::move(b);
+	std::cout << c.size() << " " << c[2] << " " << c.is_inline() << std::endl;
+}
+
+int main()
+{
+	TestConversions();
+	TestPool();
+	return 0;
+}
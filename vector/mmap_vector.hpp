@@ -0,0 +1,423 @@
+#ifndef SJTU_MMAP_VECTOR_HPP
+#define SJTU_MMAP_VECTOR_HPP
+
+#include "vector.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sjtu
+{
+    /**
+     * a vector of trivially copyable T kept in a file, which survives the process
+     * the file is mapped as a whole, so opening is O(1) and pages are read on first touch.
+     * it has the interface of sjtu::vector, with T * as iterators.
+     */
+    // NOTE: file layout: one page of Header, then capacity slots of T
+    //  the capacity grows as 2x by ftruncate + mremap, which moves the elements in memory,
+    //  so references and iterators are invalidated by a growth, as std::vector's
+    // NOTE: a file of another version or another sizeof(T) is refused with runtime_error
+    // NOTE: a read only one maps the file read only, and modifiers throw runtime_error,
+    //  while writing through a reference from operator[] faults
+    // NOTE: the index overloads of insert / erase are templates,
+    //  so that insert(0, x) does not take 0 as a null iterator
+    // NOTE: Linux only (mremap)
+    template <typename T>
+    class mmap_vector
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "mmap_vector needs a trivially copyable T");
+
+    public:
+        typedef T *iterator;
+        typedef const T *const_iterator;
+
+    private:
+        struct Header
+        {
+            char magic[8];
+            int version;
+            int type_size;
+            long long size;
+        };
+        static const size_t HEADER_SIZE = 4096;
+        static const int VERSION = 1;
+        // of a new file
+        static const size_t INITIAL_CAPACITY = (4096 + sizeof(T) - 1) / sizeof(T);
+
+        char file_path[256];
+        bool is_read_only;
+        int fd;
+        char *base; // mapping of the whole file
+        size_t map_size;
+
+        Header *header() const
+        {
+            return reinterpret_cast<Header *>(base);
+        }
+        T *storage() const
+        {
+            return reinterpret_cast<T *>(base + HEADER_SIZE);
+        }
+        size_t currentSize() const
+        {
+            return header()->size;
+        }
+
+        // >>>>> file
+        static void fillMagic(char *magic)
+        {
+            memcpy(magic, "SJTUVEC", 8);
+        }
+
+        void map()
+        {
+            int protection = is_read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+            void *p = mmap(nullptr, map_size, protection, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED)
+                throw runtime_error();
+            base = static_cast<char *>(p);
+        }
+
+        // NOTE: size is compared by division, a corrupt size overflows HEADER_SIZE + sizeof(T) * size
+        //  map_size >= HEADER_SIZE, see open()
+        void checkHeader()
+        {
+            char magic[8];
+            fillMagic(magic);
+            const Header *h = header();
+            if (memcmp(h->magic, magic, 8) != 0 || h->version != VERSION ||
+                h->type_size != (int)sizeof(T) || (h->size < 0) ||
+                (size_t)h->size > (map_size - HEADER_SIZE) / sizeof(T))
+                throw runtime_error();
+        }
+
+        void create()
+        {
+            map_size = HEADER_SIZE + sizeof(T) * INITIAL_CAPACITY;
+            if (ftruncate(fd, map_size) != 0)
+                throw runtime_error();
+            map();
+            Header *h = header();
+            fillMagic(h->magic);
+            h->version = VERSION;
+            h->type_size = sizeof(T);
+            h->size = 0;
+        }
+
+        void open()
+        {
+            fd = ::open(file_path, is_read_only ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+            if (fd == -1)
+                throw runtime_error();
+            try
+            {
+                struct stat file_stat;
+                if (fstat(fd, &file_stat) != 0)
+                    throw runtime_error();
+                if (file_stat.st_size == 0 && !is_read_only)
+                {
+                    create();
+                    return;
+                }
+                if ((size_t)file_stat.st_size < HEADER_SIZE)
+                    throw runtime_error();
+                map_size = file_stat.st_size;
+                map();
+                checkHeader();
+            }
+            catch (...)
+            {
+                close();
+                throw;
+            }
+        }
+
+        void close()
+        {
+            if (base != nullptr)
+                munmap(base, map_size);
+            if (fd != -1)
+                ::close(fd);
+            base = nullptr;
+            fd = -1;
+        }
+
+        void checkWritable() const
+        {
+            if (is_read_only)
+                throw runtime_error();
+        }
+        // <<<<< file
+
+        // raw [ind, ind + n) for new elements, with the tail moved up
+        //  returns: the first of them
+        T *openGap(size_t ind, size_t n)
+        {
+            checkWritable();
+            if (ind > currentSize())
+                throw index_out_of_bound();
+            reserve(currentSize() + n);
+            T *p = storage() + ind;
+            memmove((void *)(p + n), (const void *)p, sizeof(T) * (currentSize() - ind));
+            header()->size += n;
+            return p;
+        }
+
+        template <class InputIt>
+        iterator insertRange(iterator pos, InputIt first, InputIt last, std::forward_iterator_tag)
+        {
+            size_t ind = pos - begin(), n = std::distance(first, last);
+            T *p = openGap(ind, n);
+            for (; first != last; ++first, ++p)
+                new (p) T(*first);
+            return begin() + ind;
+        }
+
+        // a single pass range is collected first
+        template <class InputIt>
+        iterator insertRange(iterator pos, InputIt first, InputIt last, std::input_iterator_tag)
+        {
+            vector<T> collected;
+            for (; first != last; ++first)
+                collected.push_back(*first);
+            return insertRange(pos, collected.cbegin(), collected.cend(), std::forward_iterator_tag());
+        }
+
+    public:
+        // opens file_path, or creates it empty
+        // NOTE: a read only file must exist
+        explicit mmap_vector(const char *fname, bool is_read_only = false)
+            : is_read_only(is_read_only), fd(-1), base(nullptr), map_size(0)
+        {
+            strncpy(file_path, fname, sizeof(file_path) - 1);
+            file_path[sizeof(file_path) - 1] = '\0';
+            open();
+        }
+        mmap_vector(const mmap_vector &) = delete;
+        mmap_vector &operator=(const mmap_vector &) = delete;
+        ~mmap_vector()
+        {
+            close();
+        }
+
+        // write the dirty pages back and wait for them
+        void sync()
+        {
+            if (is_read_only)
+                return;
+            if (msync(base, HEADER_SIZE + sizeof(T) * currentSize(), MS_SYNC) != 0)
+                throw runtime_error();
+        }
+
+        /**
+         * assigns specified element with bounds checking
+         * throw index_out_of_bound if pos is not in [0, size)
+         */
+        T &at(const size_t &pos)
+        {
+            if (pos >= currentSize())
+                throw index_out_of_bound();
+            return storage()[pos];
+        }
+        const T &at(const size_t &pos) const
+        {
+            if (pos >= currentSize())
+                throw index_out_of_bound();
+            return storage()[pos];
+        }
+        // NOTE: checked unless SJTU_VECTOR_CHECKED is 0, as sjtu::vector
+        T &operator[](const size_t &pos)
+        {
+            if (SJTU_VECTOR_CHECKED && pos >= currentSize())
+                throw index_out_of_bound();
+            return storage()[pos];
+        }
+        const T &operator[](const size_t &pos) const
+        {
+            if (SJTU_VECTOR_CHECKED && pos >= currentSize())
+                throw index_out_of_bound();
+            return storage()[pos];
+        }
+        /**
+         * access the first / last element.
+         * throw container_is_empty if size == 0
+         */
+        const T &front() const
+        {
+            if (empty())
+                throw container_is_empty();
+            return storage()[0];
+        }
+        const T &back() const
+        {
+            if (empty())
+                throw container_is_empty();
+            return storage()[currentSize() - 1];
+        }
+
+        iterator begin()
+        {
+            return storage();
+        }
+        const_iterator cbegin() const
+        {
+            return storage();
+        }
+        iterator end()
+        {
+            return storage() + currentSize();
+        }
+        const_iterator cend() const
+        {
+            return storage() + currentSize();
+        }
+
+        bool empty() const
+        {
+            return currentSize() == 0;
+        }
+        size_t size() const
+        {
+            return currentSize();
+        }
+        size_t capacity() const
+        {
+            return (map_size - HEADER_SIZE) / sizeof(T);
+        }
+        // grow the file to at least n slots
+        void reserve(size_t n)
+        {
+            checkWritable();
+            if (n <= capacity())
+                return;
+            size_t new_capacity = capacity() << 1;
+            if (new_capacity < n)
+                new_capacity = n;
+            size_t new_map_size = HEADER_SIZE + sizeof(T) * new_capacity;
+            if (ftruncate(fd, new_map_size) != 0)
+                throw runtime_error();
+            void *p = mremap(base, map_size, new_map_size, MREMAP_MAYMOVE);
+            if (p == MAP_FAILED)
+                throw runtime_error();
+            base = static_cast<char *>(p);
+            map_size = new_map_size;
+        }
+        // NOTE: the file keeps its capacity
+        void clear()
+        {
+            checkWritable();
+            header()->size = 0;
+        }
+
+        /**
+         * inserts value before pos / at index ind.
+         * returns an iterator pointing to the inserted value.
+         * throw index_out_of_bound if ind > size
+         */
+        iterator insert(iterator pos, const T &value)
+        {
+            return insert(pos - begin(), value);
+        }
+        template <class Index,
+                  class = typename std::enable_if<std::is_integral<Index>::value>::type>
+        iterator insert(Index ind, const T &value)
+        {
+            // value may be moved by the growth
+            T copy(value);
+            T *p = openGap(ind, 1);
+            new (p) T(copy);
+            return p;
+        }
+        iterator insert(iterator pos, const size_t &count, const T &value)
+        {
+            size_t ind = pos - begin();
+            T copy(value);
+            T *p = openGap(ind, count);
+            for (size_t i = 0; i < count; ++i)
+                new (p + i) T(copy);
+            return begin() + ind;
+        }
+        // first and last should not be iterators into this vector
+        template <class InputIt,
+                  class = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+        iterator insert(iterator pos, InputIt first, InputIt last)
+        {
+            return insertRange(pos, first, last,
+                               typename std::iterator_traits<InputIt>::iterator_category());
+        }
+        template <class InputIt,
+                  class = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+        void assign(InputIt first, InputIt last)
+        {
+            clear();
+            insert(begin(), first, last);
+        }
+
+        /**
+         * removes the element at pos / with index ind / in [first, last).
+         * return an iterator pointing to the following element.
+         * throw index_out_of_bound if it is not in [0, size)
+         */
+        iterator erase(iterator pos)
+        {
+            return erase(pos - begin());
+        }
+        template <class Index,
+                  class = typename std::enable_if<std::is_integral<Index>::value>::type>
+        iterator erase(Index ind)
+        {
+            return erase(begin() + ind, begin() + ind + 1);
+        }
+        iterator erase(iterator first, iterator last)
+        {
+            checkWritable();
+            if (first < begin() || last < first || last > end())
+                throw index_out_of_bound();
+            memmove((void *)first, (const void *)last, sizeof(T) * (end() - last));
+            header()->size -= last - first;
+            return first;
+        }
+
+        void push_back(const T &value)
+        {
+            checkWritable();
+            if (currentSize() == capacity())
+            {
+                T copy(value);
+                reserve(currentSize() + 1);
+                new (end()) T(copy);
+            }
+            else
+                new (end()) T(value);
+            header()->size++;
+        }
+        template <class... Args>
+        T &emplace_back(Args &&... args)
+        {
+            push_back(T(std::forward<Args>(args)...));
+            return storage()[currentSize() - 1];
+        }
+        /**
+         * remove the last element from the end.
+         * throw container_is_empty if size() == 0
+         */
+        void pop_back()
+        {
+            checkWritable();
+            if (empty())
+                throw container_is_empty();
+            header()->size--;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef SJTU_SEGMENTED_VECTOR_HPP
+#define SJTU_SEGMENTED_VECTOR_HPP
+
+#include "vector.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sjtu
+{
+    /**
+     * a vector whose elements never move, so references stay valid while it grows,
+     *   and push_back may be called by many threads at once.
+     * elements live in segments of 32, 64, 128, ... slots, allocated on demand.
+     */
+    // NOTE: element i is slot i + 32 - 2^k of segment k, where 2^k <= i + 32 < 2^(k + 1),
+    //  so indexing is a count of leading zeros
+    // NOTE: push_back is lock-free, not wait-free: it claims a slot by a compare-and-swap of the size,
+    //  retried whenever another thread claims first, then constructs in place
+    //  the slot's segment is allocated before the claim, so that a failed allocation claims nothing,
+    //  which a wait-free fetch_add of the size cannot do (its slot would stay a hole)
+    //  threads racing to allocate a segment all allocate one, the first to publish it wins
+    //  size() counts claimed slots, so a reader running beside writers should only touch
+    //  indexes it has seen returned by push_back
+    //  the other modifiers (clear, pop_back) are not thread safe
+    // NOTE: no insert / erase in the middle, which would move elements
+    template <typename T>
+    class segmented_vector
+    {
+        static_assert(std::is_nothrow_move_constructible<T>::value,
+                      "segmented_vector moves elements into claimed slots, which cannot fail");
+
+    private:
+        static const int FIRST_SHIFT = 5; // the first segment has 2^FIRST_SHIFT slots
+        static const int N_SEGMENT = 64 - FIRST_SHIFT;
+
+        std::atomic<T *> segments[N_SEGMENT];
+        std::atomic<size_t> current_size;
+
+        static int segmentOf(size_t i)
+        {
+            return 63 - __builtin_clzll(i + ((size_t)1 << FIRST_SHIFT)) - FIRST_SHIFT;
+        }
+
+        static size_t offsetOf(size_t i, int k)
+        {
+            return i + ((size_t)1 << FIRST_SHIFT) - ((size_t)1 << (k + FIRST_SHIFT));
+        }
+
+        static size_t segmentSize(int k)
+        {
+            return (size_t)1 << (k + FIRST_SHIFT);
+        }
+
+        T *slot(size_t i) const
+        {
+            int k = segmentOf(i);
+            return segments[k].load(std::memory_order_acquire) + offsetOf(i, k);
+        }
+
+        // segment k, allocated by whichever thread gets there first
+        T *segment(int k)
+        {
+            T *ret = segments[k].load(std::memory_order_acquire);
+            if (ret != nullptr)
+                return ret;
+            T *fresh = static_cast<T *>(::operator new(sizeof(T) * segmentSize(k)));
+            if (segments[k].compare_exchange_strong(ret, fresh, std::memory_order_acq_rel))
+                return fresh;
+            ::operator delete(fresh);
+            return ret;
+        }
+
+        // T(args...) in a new slot
+        //  returns: its index
+        // NOTE: the element is built and its segment allocated before the slot is claimed,
+        //  and moving it in cannot throw, so a failure leaves no hole
+        template <class... Args>
+        size_t claim(Args &&... args)
+        {
+            T value(std::forward<Args>(args)...);
+            size_t i = current_size.load(std::memory_order_relaxed);
+            int k;
+            T *p;
+            do
+            {
+                k = segmentOf(i);
+                p = segment(k);
+            } while (!current_size.compare_exchange_weak(i, i + 1, std::memory_order_relaxed));
+            new (p + offsetOf(i, k)) T(std::move(value));
+            return i;
+        }
+
+        void destroy()
+        {
+            size_t n = current_size.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < n; ++i)
+                slot(i)->~T();
+        }
+
+        template <class Vector, class Reference, class Pointer>
+        class basic_iterator
+        {
+            friend class segmented_vector;
+            template <class V, class R, class P>
+            friend class basic_iterator;
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef Pointer pointer;
+            typedef Reference reference;
+
+        private:
+            Vector *vector_ptr;
+            size_t index;
+
+        public:
+            basic_iterator() {}
+            basic_iterator(Vector *ptr, size_t idx) : vector_ptr(ptr), index(idx) {}
+            // iterator to const_iterator
+            template <class V, class R, class P,
+                      class = typename std::enable_if<std::is_convertible<R, Reference>::value>::type>
+            basic_iterator(const basic_iterator<V, R, P> &other)
+                : vector_ptr(other.vector_ptr), index(other.index) {}
+
+            basic_iterator operator+(const int &n) const
+            {
+                return basic_iterator(vector_ptr, index + n);
+            }
+            basic_iterator operator-(const int &n) const
+            {
+                return basic_iterator(vector_ptr, index - n);
+            }
+            // throw invalid_iterator if they point to different vectors
+            int operator-(const basic_iterator &rhs) const
+            {
+                if (vector_ptr != rhs.vector_ptr)
+                    throw invalid_iterator();
+                return (int)(index - rhs.index);
+            }
+            basic_iterator &operator+=(const int &n)
+            {
+                index += n;
+                return *this;
+            }
+            basic_iterator &operator-=(const int &n)
+            {
+                index -= n;
+                return *this;
+            }
+            basic_iterator operator++(int)
+            {
+                return basic_iterator(vector_ptr, index++);
+            }
+            basic_iterator &operator++()
+            {
+                index++;
+                return *this;
+            }
+            basic_iterator operator--(int)
+            {
+                return basic_iterator(vector_ptr, index--);
+            }
+            basic_iterator &operator--()
+            {
+                index--;
+                return *this;
+            }
+            Reference operator*() const
+            {
+                return (*vector_ptr)[index];
+            }
+            Pointer operator->() const
+            {
+                return &(*vector_ptr)[index];
+            }
+            Reference operator[](const int &n) const
+            {
+                return (*vector_ptr)[index + n];
+            }
+            bool operator==(const basic_iterator &rhs) const
+            {
+                return vector_ptr == rhs.vector_ptr && index == rhs.index;
+            }
+            bool operator!=(const basic_iterator &rhs) const
+            {
+                return !(*this == rhs);
+            }
+            bool operator<(const basic_iterator &rhs) const
+            {
+                return index < rhs.index;
+            }
+            bool operator>(const basic_iterator &rhs) const
+            {
+                return index > rhs.index;
+            }
+            bool operator<=(const basic_iterator &rhs) const
+            {
+                return index <= rhs.index;
+            }
+            bool operator>=(const basic_iterator &rhs) const
+            {
+                return index >= rhs.index;
+            }
+        };
+
+    public:
+        typedef basic_iterator<segmented_vector, T &, T *> iterator;
+        typedef basic_iterator<const segmented_vector, const T &, const T *> const_iterator;
+
+        segmented_vector() : current_size(0)
+        {
+            for (int k = 0; k < N_SEGMENT; ++k)
+                segments[k].store(nullptr, std::memory_order_relaxed);
+        }
+        segmented_vector(const segmented_vector &) = delete;
+        segmented_vector &operator=(const segmented_vector &) = delete;
+        ~segmented_vector()
+        {
+            destroy();
+            for (int k = 0; k < N_SEGMENT; ++k)
+                ::operator delete(segments[k].load(std::memory_order_relaxed));
+        }
+
+        /**
+         * assigns specified element with bounds checking
+         * throw index_out_of_bound if pos is not in [0, size)
+         */
+        T &at(const size_t &pos)
+        {
+            if (pos >= size())
+                throw index_out_of_bound();
+            return *slot(pos);
+        }
+        const T &at(const size_t &pos) const
+        {
+            if (pos >= size())
+                throw index_out_of_bound();
+            return *slot(pos);
+        }
+        // NOTE: checked unless SJTU_VECTOR_CHECKED is 0, as sjtu::vector
+        T &operator[](const size_t &pos)
+        {
+            if (SJTU_VECTOR_CHECKED && pos >= size())
+                throw index_out_of_bound();
+            return *slot(pos);
+        }
+        const T &operator[](const size_t &pos) const
+        {
+            if (SJTU_VECTOR_CHECKED && pos >= size())
+                throw index_out_of_bound();
+            return *slot(pos);
+        }
+        /**
+         * access the first / last element.
+         * throw container_is_empty if size == 0
+         */
+        const T &front() const
+        {
+            if (empty())
+                throw container_is_empty();
+            return *slot(0);
+        }
+        const T &back() const
+        {
+            if (empty())
+                throw container_is_empty();
+            return *slot(size() - 1);
+        }
+
+        iterator begin()
+        {
+            return iterator(this, 0);
+        }
+        const_iterator cbegin() const
+        {
+            return const_iterator(this, 0);
+        }
+        iterator end()
+        {
+            return iterator(this, size());
+        }
+        const_iterator cend() const
+        {
+            return const_iterator(this, size());
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+        // claimed slots, see the NOTE above
+        size_t size() const
+        {
+            return current_size.load(std::memory_order_relaxed);
+        }
+        // NOTE: the segments are kept
+        void clear()
+        {
+            destroy();
+            current_size.store(0, std::memory_order_release);
+        }
+
+        /**
+         * adds an element to the end, safe to call from many threads.
+         * returns the index of the new element.
+         */
+        size_t push_back(const T &value)
+        {
+            return claim(value);
+        }
+        size_t push_back(T &&value)
+        {
+            return claim(std::move(value));
+        }
+        /**
+         * constructs T(args...) at the end, safe to call from many threads.
+         * returns a reference to it, which stays valid.
+         */
+        template <class... Args>
+        T &emplace_back(Args &&... args)
+        {
+            return *slot(claim(std::forward<Args>(args)...));
+        }
+        /**
+         * remove the last element from the end.
+         * throw container_is_empty if size() == 0
+         */
+        void pop_back()
+        {
+            if (empty())
+                throw container_is_empty();
+            size_t i = current_size.fetch_sub(1, std::memory_order_relaxed) - 1;
+            slot(i)->~T();
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,466 @@
+#ifndef SJTU_SIMD_HPP
+#define SJTU_SIMD_HPP
+
+#include "vector.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SJTU_SIMD_X86 1
+// a function compiled for AVX2, whatever -m flags the rest is built with
+#define SJTU_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#else
+#define SJTU_SIMD_X86 0
+#endif
+
+namespace sjtu
+{
+    /**
+     * search and reduction kernels over a buffer of arithmetic T
+     * those of int, long long and double run 256-bit AVX2 code when the CPU has it,
+     *   checked once at run time, so one binary runs everywhere;
+     *   other types and CPUs take the plain loops, left to the compiler to vectorize for SSE.
+     * see find, count, contains, min_value, max_value and sum below for sjtu::vector.
+     */
+    // NOTE: AVX2 loops read 4 registers per iteration, the remainder goes through the plain loop
+    // NOTE: AVX2 sums of double are added in 16 lanes, so they may round differently
+    //  from the left-to-right plain loop, and min / max of double are unspecified with NaN
+    namespace simd
+    {
+        // the sum of T, widened so that a vector of int does not overflow
+        template <class T>
+        struct sum_type
+        {
+            typedef typename std::conditional<
+                std::is_floating_point<T>::value, double,
+                typename std::conditional<std::is_signed<T>::value,
+                                          long long, unsigned long long>::type>::type type;
+        };
+
+        // whether the CPU has AVX2
+        inline bool hasAvx2()
+        {
+#if defined(__AVX2__)
+            return true;
+#elif SJTU_SIMD_X86
+            static const bool ret = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+            return ret;
+#else
+            return false;
+#endif
+        }
+
+        // >>>>> plain loops
+        // index of the first value in p[0, n), n if none
+        template <class T>
+        size_t findScalar(const T *p, size_t n, T value)
+        {
+            for (size_t i = 0; i < n; ++i)
+                if (p[i] == value)
+                    return i;
+            return n;
+        }
+
+        template <class T>
+        size_t countScalar(const T *p, size_t n, T value)
+        {
+            size_t ret = 0;
+            for (size_t i = 0; i < n; ++i)
+                ret += p[i] == value;
+            return ret;
+        }
+
+        // min (max if IS_MAX) of p[0, n) and init
+        template <class T, bool IS_MAX>
+        T extremeScalar(const T *p, size_t n, T init)
+        {
+            T ret = init;
+            for (size_t i = 0; i < n; ++i)
+                ret = (IS_MAX ? ret < p[i] : p[i] < ret) ? p[i] : ret;
+            return ret;
+        }
+
+        template <class T>
+        typename sum_type<T>::type sumScalar(const T *p, size_t n)
+        {
+            typename sum_type<T>::type ret = 0;
+            for (size_t i = 0; i < n; ++i)
+                ret += p[i];
+            return ret;
+        }
+        // <<<<< plain loops
+
+        // whether T has the AVX2 kernels, by a specialization of Avx2<T>
+        template <class T>
+        struct Avx2
+        {
+            static const bool IS_SUPPORTED = false;
+        };
+
+#if SJTU_SIMD_X86
+        // >>>>> AVX2 lanes
+        // Reg holds WIDTH of T, and Acc 4 partial sums
+        template <>
+        struct Avx2<int>
+        {
+            static const bool IS_SUPPORTED = true;
+            static const int WIDTH = 8;
+            typedef __m256i Reg;
+            typedef __m256i Acc;
+
+            SJTU_TARGET_AVX2 static Reg load(const int *p)
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            }
+            SJTU_TARGET_AVX2 static void store(int *p, Reg x)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+            }
+            SJTU_TARGET_AVX2 static Reg broadcast(int x)
+            {
+                return _mm256_set1_epi32(x);
+            }
+            // bit k is whether lane k of x and y are equal
+            SJTU_TARGET_AVX2 static unsigned equal(Reg x, Reg y)
+            {
+                return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, y)));
+            }
+            SJTU_TARGET_AVX2 static Reg min(Reg x, Reg y)
+            {
+                return _mm256_min_epi32(x, y);
+            }
+            SJTU_TARGET_AVX2 static Reg max(Reg x, Reg y)
+            {
+                return _mm256_max_epi32(x, y);
+            }
+            SJTU_TARGET_AVX2 static Acc zero()
+            {
+                return _mm256_setzero_si256();
+            }
+            // sign extended to 64 bits
+            SJTU_TARGET_AVX2 static Acc add(Acc acc, Reg x)
+            {
+                acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+                return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+            }
+            SJTU_TARGET_AVX2 static Acc merge(Acc x, Acc y)
+            {
+                return _mm256_add_epi64(x, y);
+            }
+            SJTU_TARGET_AVX2 static void storeAcc(long long *p, Acc x)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+            }
+        };
+
+        template <>
+        struct Avx2<long long>
+        {
+            static const bool IS_SUPPORTED = true;
+            static const int WIDTH = 4;
+            typedef __m256i Reg;
+            typedef __m256i Acc;
+
+            SJTU_TARGET_AVX2 static Reg load(const long long *p)
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            }
+            SJTU_TARGET_AVX2 static void store(long long *p, Reg x)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+            }
+            SJTU_TARGET_AVX2 static Reg broadcast(long long x)
+            {
+                return _mm256_set1_epi64x(x);
+            }
+            SJTU_TARGET_AVX2 static unsigned equal(Reg x, Reg y)
+            {
+                return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, y)));
+            }
+            // NOTE: AVX2 has no 64-bit min / max, so they are a compare and a blend
+            SJTU_TARGET_AVX2 static Reg min(Reg x, Reg y)
+            {
+                return _mm256_blendv_epi8(x, y, _mm256_cmpgt_epi64(x, y));
+            }
+            SJTU_TARGET_AVX2 static Reg max(Reg x, Reg y)
+            {
+                return _mm256_blendv_epi8(y, x, _mm256_cmpgt_epi64(x, y));
+            }
+            SJTU_TARGET_AVX2 static Acc zero()
+            {
+                return _mm256_setzero_si256();
+            }
+            SJTU_TARGET_AVX2 static Acc add(Acc acc, Reg x)
+            {
+                return _mm256_add_epi64(acc, x);
+            }
+            SJTU_TARGET_AVX2 static Acc merge(Acc x, Acc y)
+            {
+                return _mm256_add_epi64(x, y);
+            }
+            SJTU_TARGET_AVX2 static void storeAcc(long long *p, Acc x)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+            }
+        };
+
+        template <>
+        struct Avx2<double>
+        {
+            static const bool IS_SUPPORTED = true;
+            static const int WIDTH = 4;
+            typedef __m256d Reg;
+            typedef __m256d Acc;
+
+            SJTU_TARGET_AVX2 static Reg load(const double *p)
+            {
+                return _mm256_loadu_pd(p);
+            }
+            SJTU_TARGET_AVX2 static void store(double *p, Reg x)
+            {
+                _mm256_storeu_pd(p, x);
+            }
+            SJTU_TARGET_AVX2 static Reg broadcast(double x)
+            {
+                return _mm256_set1_pd(x);
+            }
+            // ordered, as ==, so NaN equals nothing
+            SJTU_TARGET_AVX2 static unsigned equal(Reg x, Reg y)
+            {
+                return _mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_EQ_OQ));
+            }
+            SJTU_TARGET_AVX2 static Reg min(Reg x, Reg y)
+            {
+                return _mm256_min_pd(x, y);
+            }
+            SJTU_TARGET_AVX2 static Reg max(Reg x, Reg y)
+            {
+                return _mm256_max_pd(x, y);
+            }
+            SJTU_TARGET_AVX2 static Acc zero()
+            {
+                return _mm256_setzero_pd();
+            }
+            SJTU_TARGET_AVX2 static Acc add(Acc acc, Reg x)
+            {
+                return _mm256_add_pd(acc, x);
+            }
+            SJTU_TARGET_AVX2 static Acc merge(Acc x, Acc y)
+            {
+                return _mm256_add_pd(x, y);
+            }
+            SJTU_TARGET_AVX2 static void storeAcc(double *p, Acc x)
+            {
+                _mm256_storeu_pd(p, x);
+            }
+        };
+        // <<<<< AVX2 lanes
+
+        // >>>>> AVX2 kernels
+        // equal bits of 4 registers from p, lane k of register j at bit j * WIDTH + k
+        template <class T>
+        SJTU_TARGET_AVX2 unsigned long long equal4(const T *p, typename Avx2<T>::Reg x)
+        {
+            typedef Avx2<T> V;
+            const int W = V::WIDTH;
+            return (unsigned long long)V::equal(V::load(p), x) |
+                   (unsigned long long)V::equal(V::load(p + W), x) << W |
+                   (unsigned long long)V::equal(V::load(p + 2 * W), x) << 2 * W |
+                   (unsigned long long)V::equal(V::load(p + 3 * W), x) << 3 * W;
+        }
+
+        template <class T>
+        SJTU_TARGET_AVX2 size_t findAvx2(const T *p, size_t n, T value)
+        {
+            const size_t STEP = 4 * Avx2<T>::WIDTH;
+            typename Avx2<T>::Reg x = Avx2<T>::broadcast(value);
+            size_t i = 0;
+            for (; i + STEP <= n; i += STEP)
+            {
+                unsigned long long mask = equal4(p + i, x);
+                if (mask != 0)
+                    return i + __builtin_ctzll(mask);
+            }
+            return i + findScalar(p + i, n - i, value);
+        }
+
+        template <class T>
+        SJTU_TARGET_AVX2 size_t countAvx2(const T *p, size_t n, T value)
+        {
+            const size_t STEP = 4 * Avx2<T>::WIDTH;
+            typename Avx2<T>::Reg x = Avx2<T>::broadcast(value);
+            size_t ret = 0, i = 0;
+            for (; i + STEP <= n; i += STEP)
+                ret += __builtin_popcountll(equal4(p + i, x));
+            return ret + countScalar(p + i, n - i, value);
+        }
+
+        template <class T, bool IS_MAX>
+        SJTU_TARGET_AVX2 typename Avx2<T>::Reg pick(typename Avx2<T>::Reg x, typename Avx2<T>::Reg y)
+        {
+            return IS_MAX ? Avx2<T>::max(x, y) : Avx2<T>::min(x, y);
+        }
+
+        template <class T, bool IS_MAX>
+        SJTU_TARGET_AVX2 T extremeAvx2(const T *p, size_t n, T init)
+        {
+            typedef Avx2<T> V;
+            const int W = V::WIDTH;
+            const size_t STEP = 4 * W;
+            if (n < STEP)
+                return extremeScalar<T, IS_MAX>(p, n, init);
+            typename V::Reg r0 = V::load(p), r1 = V::load(p + W),
+                            r2 = V::load(p + 2 * W), r3 = V::load(p + 3 * W);
+            size_t i = STEP;
+            for (; i + STEP <= n; i += STEP)
+            {
+                r0 = pick<T, IS_MAX>(r0, V::load(p + i));
+                r1 = pick<T, IS_MAX>(r1, V::load(p + i + W));
+                r2 = pick<T, IS_MAX>(r2, V::load(p + i + 2 * W));
+                r3 = pick<T, IS_MAX>(r3, V::load(p + i + 3 * W));
+            }
+            T lanes[W];
+            V::store(lanes, pick<T, IS_MAX>(pick<T, IS_MAX>(r0, r1), pick<T, IS_MAX>(r2, r3)));
+            init = extremeScalar<T, IS_MAX>(lanes, W, init);
+            return extremeScalar<T, IS_MAX>(p + i, n - i, init);
+        }
+
+        template <class T>
+        SJTU_TARGET_AVX2 typename sum_type<T>::type sumAvx2(const T *p, size_t n)
+        {
+            typedef Avx2<T> V;
+            const int W = V::WIDTH;
+            const size_t STEP = 4 * W;
+            typename V::Acc a0 = V::zero(), a1 = V::zero(), a2 = V::zero(), a3 = V::zero();
+            size_t i = 0;
+            for (; i + STEP <= n; i += STEP)
+            {
+                a0 = V::add(a0, V::load(p + i));
+                a1 = V::add(a1, V::load(p + i + W));
+                a2 = V::add(a2, V::load(p + i + 2 * W));
+                a3 = V::add(a3, V::load(p + i + 3 * W));
+            }
+            typename sum_type<T>::type lanes[4];
+            V::storeAcc(lanes, V::merge(V::merge(a0, a1), V::merge(a2, a3)));
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sumScalar(p + i, n - i);
+        }
+        // <<<<< AVX2 kernels
+#endif
+
+        // the kernels of T, by whether it has AVX2 ones
+        template <class T, bool HAS_AVX2 = Avx2<T>::IS_SUPPORTED>
+        struct dispatch
+        {
+            static size_t find(const T *p, size_t n, T value)
+            {
+                return findScalar(p, n, value);
+            }
+            static size_t count(const T *p, size_t n, T value)
+            {
+                return countScalar(p, n, value);
+            }
+            template <bool IS_MAX>
+            static T extreme(const T *p, size_t n, T init)
+            {
+                return extremeScalar<T, IS_MAX>(p, n, init);
+            }
+            static typename sum_type<T>::type sum(const T *p, size_t n)
+            {
+                return sumScalar(p, n);
+            }
+        };
+
+#if SJTU_SIMD_X86
+        template <class T>
+        struct dispatch<T, true>
+        {
+            static size_t find(const T *p, size_t n, T value)
+            {
+                return hasAvx2() ? findAvx2(p, n, value) : findScalar(p, n, value);
+            }
+            static size_t count(const T *p, size_t n, T value)
+            {
+                return hasAvx2() ? countAvx2(p, n, value) : countScalar(p, n, value);
+            }
+            template <bool IS_MAX>
+            static T extreme(const T *p, size_t n, T init)
+            {
+                return hasAvx2() ? extremeAvx2<T, IS_MAX>(p, n, init)
+                                 : extremeScalar<T, IS_MAX>(p, n, init);
+            }
+            static typename sum_type<T>::type sum(const T *p, size_t n)
+            {
+                return hasAvx2() ? sumAvx2(p, n) : sumScalar(p, n);
+            }
+        };
+#endif
+    }
+
+    // >>>>> algorithms of arithmetic vectors
+    // NOTE: value is not deduced, so that find(v, 5) takes 5 as a long long for a vector<long long>
+    /**
+     * the index of the first element equal to value.
+     * returns size() if there is none.
+     */
+    template <class T, class Allocator,
+              class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    size_t find(const vector<T, Allocator> &v,
+                const typename vector<T, Allocator>::value_type &value)
+    {
+        return simd::dispatch<T>::find(v.data(), v.size(), value);
+    }
+
+    template <class T, class Allocator,
+              class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    size_t count(const vector<T, Allocator> &v,
+                 const typename vector<T, Allocator>::value_type &value)
+    {
+        return simd::dispatch<T>::count(v.data(), v.size(), value);
+    }
+
+    template <class T, class Allocator,
+              class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    bool contains(const vector<T, Allocator> &v,
+                  const typename vector<T, Allocator>::value_type &value)
+    {
+        return find(v, value) != v.size();
+    }
+
+    /**
+     * the least / greatest element.
+     * throw container_is_empty if size == 0
+     */
+    template <class T, class Allocator,
+              class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    T min_value(const vector<T, Allocator> &v)
+    {
+        if (v.empty())
+            throw container_is_empty();
+        return simd::dispatch<T>::template extreme<false>(v.data(), v.size(), v.data()[0]);
+    }
+    template <class T, class Allocator,
+              class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    T max_value(const vector<T, Allocator> &v)
+    {
+        if (v.empty())
+            throw container_is_empty();
+        return simd::dispatch<T>::template extreme<true>(v.data(), v.size(), v.data()[0]);
+    }
+
+    /**
+     * the sum of the elements, as a long long, unsigned long long or double.
+     */
+    // NOTE: integer overflow is not detected
+    template <class T, class Allocator,
+              class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    typename simd::sum_type<T>::type sum(const vector<T, Allocator> &v)
+    {
+        return simd::dispatch<T>::sum(v.data(), v.size());
+    }
+    // <<<<< algorithms of arithmetic vectors
+
+}
+
+#endif
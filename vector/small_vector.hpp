@@ -0,0 +1,86 @@
+#ifndef SJTU_SMALL_VECTOR_HPP
+#define SJTU_SMALL_VECTOR_HPP
+
+#include "vector.hpp"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace sjtu
+{
+    /**
+     * a vector storing up to N elements inline, in the object itself,
+     *   and spilling to Allocator only beyond that.
+     * it is a sjtu::vector, with the same interface and iterators,
+     *   so it can be passed wherever a vector<T, Allocator> & is expected.
+     */
+    // NOTE: once spilled it stays on the heap, even if it shrinks
+    template <typename T, int N, class Allocator = std::allocator<T>>
+    class small_vector : public vector<T, Allocator>
+    {
+        static_assert(N > 0, "small_vector needs an inline capacity");
+
+    private:
+        typedef vector<T, Allocator> base;
+        typedef std::allocator_traits<Allocator> alloc_traits;
+
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type buffer[N];
+
+        T *inlineStorage()
+        {
+            return reinterpret_cast<T *>(buffer);
+        }
+
+    public:
+        small_vector() : base(inlineStorage(), N, Allocator()) {}
+        explicit small_vector(const Allocator &alloc) : base(inlineStorage(), N, alloc) {}
+        small_vector(const small_vector &other)
+            : base(inlineStorage(), N,
+                   alloc_traits::select_on_container_copy_construction(other.get_allocator()))
+        {
+            base::operator=(other);
+        }
+        small_vector(const base &other)
+            : base(inlineStorage(), N,
+                   alloc_traits::select_on_container_copy_construction(other.get_allocator()))
+        {
+            base::operator=(other);
+        }
+        // NOTE: inline elements of other are moved one by one
+        small_vector(small_vector &&other) : base(inlineStorage(), N, other.get_allocator())
+        {
+            base::operator=(std::move(other));
+        }
+        small_vector(base &&other) : base(inlineStorage(), N, other.get_allocator())
+        {
+            base::operator=(std::move(other));
+        }
+        // the elements go before the buffer does
+        ~small_vector()
+        {
+            this->clear();
+        }
+
+        small_vector &operator=(const small_vector &other)
+        {
+            base::operator=(other);
+            return *this;
+        }
+        small_vector &operator=(small_vector &&other)
+        {
+            base::operator=(std::move(other));
+            return *this;
+        }
+        using base::operator=;
+
+        // whether the elements are in the inline buffer
+        bool is_inline() const
+        {
+            return base::isInline();
+        }
+    };
+
+}
+
+#endif
@@ -5,20 +5,497 @@
 
 #include <climits>
 #include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// whether operator[] and iterators check their bounds and throw, as at() always does
+//  on by default, off with NDEBUG or -DSJTU_VECTOR_CHECKED=0
+// NOTE: unchecked iterators are raw pointers, invalidated by a reallocation as std::vector's,
+//  while checked ones are (vector, index) and survive it
+#ifndef SJTU_VECTOR_CHECKED
+#ifdef NDEBUG
+#define SJTU_VECTOR_CHECKED 0
+#else
+#define SJTU_VECTOR_CHECKED 1
+#endif
+#endif
 
 namespace sjtu
 {
+    // whether a T can be moved to raw memory by memcpy, and the source forgotten
+    //  specialize it for types owning their resources only through pointers, e.g.
+    //      template <> struct sjtu::is_trivially_relocatable<Util::Bint> : std::true_type {};
+    // NOTE: never for types pointing into themselves
+    template <class T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T>
+    {
+    };
+
     /**
      * a Data container like std::vector
      * store Data in a successive memory and support random access.
      */
-    template <typename T>
+    // NOTE: elements live in one raw buffer of max_size slots,
+    //  [0, current_size) are constructed in place and the rest are raw,
+    //  so T only needs a copy or move constructor
+    // NOTE: the buffer and the elements go through Allocator as std::allocator_traits,
+    //  whose pointer should be T *, see allocator.hpp for an arena and a pool
+    // NOTE: a derived small_vector lends an inline buffer of inline_size slots,
+    //  which is used while it is large enough and never deallocated
+    template <typename T, class Allocator = std::allocator<T>>
     class vector
     {
+        static_assert(std::is_same<typename Allocator::value_type, T>::value,
+                      "Allocator::value_type should be T");
+
+    public:
+        typedef T value_type;
+        typedef Allocator allocator_type;
+
     private:
-        T **storage;
+        typedef std::allocator_traits<Allocator> alloc_traits;
+
+        T *storage;
         int current_size;
         int max_size;
+        T *inline_storage; // nullptr if none
+        int inline_size;
+        Allocator alloc;
+
+        // >>>>> raw storage
+        T *allocate(int n)
+        {
+            return n > 0 ? alloc_traits::allocate(alloc, n) : nullptr;
+        }
+
+        // p is nullptr, inline_storage or has n slots
+        void deallocate(T *p, int n)
+        {
+            if (p != nullptr && p != inline_storage)
+                alloc_traits::deallocate(alloc, p, n);
+        }
+
+        void destroy(T *first, T *last)
+        {
+            for (; first != last; ++first)
+                alloc_traits::destroy(alloc, first);
+        }
+
+        // T(args...) in raw slot p
+        template <class... Args>
+        void build(T *p, Args &&... args)
+        {
+            alloc_traits::construct(alloc, p, std::forward<Args>(args)...);
+        }
+
+        // copy n elements from first to raw to[0, n), moved if first is a std::move_iterator
+        //  if a copy throws, the copied ones are destroyed
+        template <class InputIt>
+        void construct(InputIt first, int n, T *to)
+        {
+            int i = 0;
+            try
+            {
+                for (; i < n; ++i, ++first)
+                    build(to + i, *first);
+            }
+            catch (...)
+            {
+                destroy(to, to + i);
+                throw;
+            }
+        }
+
+        // an iterator repeating one value, for construct()
+        struct Repeat
+        {
+            const T *value;
+
+            const T &operator*() const
+            {
+                return *value;
+            }
+            Repeat &operator++()
+            {
+                return *this;
+            }
+        };
+
+        // elements are moved by memcpy / memmove, and never destroyed after
+        // NOTE: this bypasses Allocator::construct / destroy
+        static const bool IS_RELOCATABLE = is_trivially_relocatable<T>::value;
+
+        // elements are moved only if it cannot throw, as std::move_if_noexcept,
+        //  otherwise copied, so that a failed copy leaves the source intact
+        static const bool IS_NOTHROW_MOVE = std::is_nothrow_move_constructible<T>::value ||
+                                            !std::is_copy_constructible<T>::value;
+
+        // move or copy [first, first + n) to raw to[0, n), see IS_NOTHROW_MOVE
+        void transfer(T *first, int n, T *to)
+        {
+            transfer(first, n, to, std::integral_constant<bool, IS_NOTHROW_MOVE>());
+        }
+
+        // move [first, first + n) to first[d, d + n), where the uncovered slots become raw
+        static void relocate(T *first, int n, int d)
+        {
+            memmove((void *)(first + d), (const void *)first, sizeof(T) * n);
+        }
+
+        // if a move throws (a move only T), the moved ones are destroyed, as construct()
+        void transfer(T *first, int n, T *to, std::true_type)
+        {
+            int i = 0;
+            try
+            {
+                for (; i < n; ++i)
+                    build(to + i, std::move(first[i]));
+            }
+            catch (...)
+            {
+                destroy(to, to + i);
+                throw;
+            }
+        }
+
+        void transfer(T *first, int n, T *to, std::false_type)
+        {
+            construct(first, n, to);
+        }
+
+        // move slot from into destroyed slot to
+        void shift(T *from, T *to)
+        {
+            build(to, std::move_if_noexcept(*from));
+        }
+
+        // move [ind, size) up to [ind + k, size + k), leaving [ind, ind + k) raw
+        //  size is not changed
+        //  if a shift throws, the shifted elements are destroyed and size is cut to the others
+        void openGap(int ind, int k)
+        {
+            if (IS_RELOCATABLE)
+            {
+                relocate(storage + ind, current_size - ind, k);
+                return;
+            }
+            int i = current_size - 1;
+            try
+            {
+                for (; i >= ind; --i)
+                {
+                    shift(storage + i, storage + i + k);
+                    destroy(storage + i, storage + i + 1);
+                }
+            }
+            catch (...)
+            {
+                destroy(storage + i + k + 1, storage + current_size + k);
+                current_size = i + 1;
+                throw;
+            }
+        }
+
+        // move [ind + k, end) down to raw [ind, end - k), leaving [end - k, end) raw
+        //  if a shift throws, the unshifted elements are destroyed and size is cut to the others
+        void closeGap(int ind, int k, int end)
+        {
+            if (IS_RELOCATABLE)
+            {
+                relocate(storage + ind + k, end - ind - k, -k);
+                return;
+            }
+            int i = ind + k;
+            try
+            {
+                for (; i < end; ++i)
+                {
+                    shift(storage + i, storage + i - k);
+                    destroy(storage + i, storage + i + 1);
+                }
+            }
+            catch (...)
+            {
+                destroy(storage + i, storage + end);
+                current_size = i - k;
+                throw;
+            }
+        }
+
+        // a buffer of new_max_size slots with k new elements at [ind, ind + k),
+        //  built by fill(new_storage + ind), and the old elements around them
+        //  fill should leave no element if it throws
+        //  the old buffer is released only if every transfer succeeds
+        // NOTE: the new elements are constructed first, as they may be copies of old ones
+        template <class Fill>
+        void reallocate(int new_max_size, int ind, int k, Fill fill)
+        {
+            T *new_storage = allocate(new_max_size);
+            try
+            {
+                fill(new_storage + ind);
+            }
+            catch (...)
+            {
+                deallocate(new_storage, new_max_size);
+                throw;
+            }
+            if (IS_RELOCATABLE)
+            {
+                if (current_size > 0)
+                {
+                    memcpy((void *)new_storage, (const void *)storage, sizeof(T) * ind);
+                    memcpy((void *)(new_storage + ind + k), (const void *)(storage + ind),
+                           sizeof(T) * (current_size - ind));
+                }
+            }
+            else
+            {
+                bool is_front_done = false;
+                try
+                {
+                    transfer(storage, ind, new_storage);
+                    is_front_done = true;
+                    transfer(storage + ind, current_size - ind, new_storage + ind + k);
+                }
+                catch (...)
+                {
+                    destroy(new_storage + ind, new_storage + ind + k);
+                    if (is_front_done)
+                        destroy(new_storage, new_storage + ind);
+                    deallocate(new_storage, new_max_size);
+                    throw;
+                }
+                destroy(storage, storage + current_size);
+            }
+            deallocate(storage, max_size);
+            storage = new_storage;
+            max_size = new_max_size;
+            current_size += k;
+        }
+
+        // a buffer of max(2 * max_size, 1) slots with T(args...) at [ind]
+        template <class... Args>
+        void grow(int ind, Args &&... args)
+        {
+            reallocate(max_size > 0 ? max_size << 1 : 1, ind, 1, [&](T *to) {
+                build(to, std::forward<Args>(args)...);
+            });
+        }
+
+        // n elements from first at [ind, ind + n), which is in [0, size],
+        //  where the tail is shifted once and the buffer grows at most once
+        //  if a copy throws, this is unchanged (but see emplaceAt for a move only T)
+        // NOTE: if there is a tail to shift and shifting may throw,
+        //  the elements are copied into a new buffer instead
+        template <class InputIt>
+        void insertAt(int ind, InputIt first, int n)
+        {
+            if (n == 0)
+                return;
+            if (current_size + n > max_size ||
+                (!IS_RELOCATABLE && !IS_NOTHROW_MOVE && ind < current_size))
+            {
+                int new_max_size = max_size > 0 ? max_size << 1 : 1;
+                if (current_size + n <= max_size)
+                    new_max_size = max_size;
+                if (new_max_size < current_size + n)
+                    new_max_size = current_size + n;
+                reallocate(new_max_size, ind, n, [&](T *to) {
+                    construct(first, n, to);
+                });
+                return;
+            }
+            openGap(ind, n);
+            try
+            {
+                construct(first, n, storage + ind);
+            }
+            catch (...)
+            {
+                closeGap(ind, n, current_size + n);
+                throw;
+            }
+            current_size += n;
+        }
+
+        template <class InputIt>
+        void insertAt(int ind, InputIt first, InputIt last, std::forward_iterator_tag)
+        {
+            insertAt(ind, first, std::distance(first, last));
+        }
+
+        // a single pass range is collected first
+        template <class InputIt>
+        void insertAt(int ind, InputIt first, InputIt last, std::input_iterator_tag)
+        {
+            vector collected(alloc);
+            for (; first != last; ++first)
+                collected.emplace_back(*first);
+            insertAt(ind, std::make_move_iterator(collected.storage), collected.current_size);
+        }
+
+        // T(args...) at [ind], which is in [0, size]
+        //  if it throws, this is unchanged, unless T is move only with a throwing move,
+        //  where a shift may fail and the vector keeps only the elements before it
+        template <class... Args>
+        void emplaceAt(int ind, Args &&... args)
+        {
+            if (current_size == max_size)
+            {
+                grow(ind, std::forward<Args>(args)...);
+                return;
+            }
+            if (ind == current_size)
+            {
+                build(storage + current_size, std::forward<Args>(args)...);
+                current_size++;
+                return;
+            }
+            // as insertAt, if shifting may throw, the element goes into a new buffer instead
+            //  appends never get here, they have nothing to shift
+            if (!IS_RELOCATABLE && !IS_NOTHROW_MOVE)
+            {
+                reallocate(max_size, ind, 1, [&](T *to) {
+                    build(to, std::forward<Args>(args)...);
+                });
+                return;
+            }
+            // args may be shifted away
+            T value(std::forward<Args>(args)...);
+            openGap(ind, 1);
+            try
+            {
+                build(storage + ind, std::move(value));
+            }
+            catch (...)
+            {
+                closeGap(ind, 1, current_size + 1);
+                throw;
+            }
+            current_size++;
+        }
+
+        // remove [ind, ind + n), which is in [0, size)
+        // NOTE: if shifting the tail throws, the vector keeps the elements before it, see closeGap
+        void eraseAt(int ind, int n)
+        {
+            if (n == 0)
+                return;
+            destroy(storage + ind, storage + ind + n);
+            closeGap(ind, n, current_size);
+            current_size -= n;
+        }
+
+        // copy other into this empty vector, whose allocator is set
+        void copyFrom(const vector &other)
+        {
+            storage = allocate(other.current_size);
+            try
+            {
+                construct(other.storage, other.current_size, storage);
+            }
+            catch (...)
+            {
+                deallocate(storage, other.current_size);
+                throw;
+            }
+            current_size = max_size = other.current_size;
+        }
+
+        // destroy the elements, and fall back to the inline buffer if any
+        void release()
+        {
+            destroy(storage, storage + current_size);
+            deallocate(storage, max_size);
+            storage = inline_storage;
+            current_size = 0;
+            max_size = inline_size;
+        }
+
+        // take the elements of other into this released vector, whose allocator is equal
+        //  a heap buffer is taken as a whole, and other falls back to its inline buffer
+        //  inline elements are moved one by one, as std::move_if_noexcept
+        void steal(vector &other)
+        {
+            if (other.storage != other.inline_storage)
+            {
+                storage = other.storage;
+                current_size = other.current_size;
+                max_size = other.max_size;
+                other.storage = other.inline_storage;
+                other.current_size = 0;
+                other.max_size = other.inline_size;
+                return;
+            }
+            if (other.current_size > max_size)
+            {
+                storage = allocate(other.current_size);
+                max_size = other.current_size;
+            }
+            transfer(other.storage, other.current_size, storage);
+            current_size = other.current_size;
+            other.clear();
+        }
+
+        // NOTE: as std::vector, move assignment steals the buffer
+        //  if the allocator propagates or both are equal
+        void moveAssign(vector &other, std::true_type)
+        {
+            release();
+            alloc = std::move(other.alloc);
+            steal(other);
+        }
+
+        //  otherwise the elements are moved one by one into a buffer of this allocator
+        void moveAssign(vector &other, std::false_type)
+        {
+            if (alloc == other.alloc)
+            {
+                release();
+                steal(other);
+                return;
+            }
+            if (other.current_size <= max_size)
+            {
+                clear();
+                transfer(other.storage, other.current_size, storage);
+                current_size = other.current_size;
+                other.clear();
+                return;
+            }
+            T *new_storage = allocate(other.current_size);
+            try
+            {
+                transfer(other.storage, other.current_size, new_storage);
+            }
+            catch (...)
+            {
+                deallocate(new_storage, other.current_size);
+                throw;
+            }
+            destroy(storage, storage + current_size);
+            deallocate(storage, max_size);
+            storage = new_storage;
+            current_size = max_size = other.current_size;
+            other.clear();
+        }
+        // <<<<< raw storage
+
+    protected:
+        // an empty vector on the inline buffer of a small_vector
+        vector(T *buffer, int n, const Allocator &alloc)
+            : storage(buffer), current_size(0), max_size(n),
+              inline_storage(buffer), inline_size(n), alloc(alloc) {}
+
+        bool isInline() const
+        {
+            return storage == inline_storage;
+        }
 
     public:
         /**
@@ -32,53 +509,92 @@ namespace sjtu
         class const_iterator;
         class iterator
         {
+            friend class vector;
+            friend class const_iterator;
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef T *pointer;
+            typedef T &reference;
+
         private:
-            vector<T> *vector_ptr;
-            int index;
+#if SJTU_VECTOR_CHECKED
+            vector *vector_ptr;
+            int pos;
+
+            T &get(int n) const
+            {
+                return vector_ptr->at(pos + n);
+            }
+            const vector *owner() const
+            {
+                return vector_ptr;
+            }
+            int index(const vector *) const
+            {
+                return pos;
+            }
+#else
+            T *pos;
+
+            T &get(int n) const
+            {
+                return pos[n];
+            }
+            const vector *owner() const
+            {
+                return nullptr;
+            }
+            int index(const vector *v) const
+            {
+                return pos - v->storage;
+            }
+#endif
             /**
              * TODO add Data members
              *   just add whatever you want.
              */
         public:
             iterator() {}
-            iterator(vector<T> *ptr, int idx) : vector_ptr(ptr), index(idx) {}
-            iterator(const iterator &other)
-            {
-                vector_ptr = other.vector_ptr;
-                index = other.index;
-            }
-            int iterator_pos()
-            {
-                return index;
-            }
+#if SJTU_VECTOR_CHECKED
+            iterator(vector *ptr, int idx) : vector_ptr(ptr), pos(idx) {}
+#else
+            iterator(vector *ptr, int idx) : pos(ptr->storage + idx) {}
+#endif
             /**
              * return a new iterator which pointer n-next elements
              * as well as operator-
              */
             iterator operator+(const int &n) const
             {
-                return iterator(vector_ptr, index + n);
+                iterator ret(*this);
+                ret.pos += n;
+                return ret;
             }
             iterator operator-(const int &n) const
             {
-                return iterator(vector_ptr, index - n);
+                iterator ret(*this);
+                ret.pos -= n;
+                return ret;
             }
             // return the distance between two iterators,
             // if these two iterators point to different vectors, throw invalid_iterator.
             int operator-(const iterator &rhs) const
             {
-                if (vector_ptr != rhs.vector_ptr)
+                if (owner() != rhs.owner())
                     throw invalid_iterator();
-                return index - rhs.index;
+                return pos - rhs.pos;
             }
             iterator &operator+=(const int &n)
             {
-                index += n;
+                pos += n;
                 return *this;
             }
             iterator &operator-=(const int &n)
             {
-                index -= n;
+                pos -= n;
                 return *this;
             }
             /**
@@ -87,7 +603,7 @@ namespace sjtu
             iterator operator++(int)
             {
                 iterator ret(*this);
-                index++;
+                pos++;
                 return ret;
             }
             /**
@@ -95,7 +611,7 @@ namespace sjtu
              */
             iterator &operator++()
             {
-                index++;
+                pos++;
                 return *this;
             }
             /**
@@ -104,7 +620,7 @@ namespace sjtu
             iterator operator--(int)
             {
                 iterator ret(*this);
-                index--;
+                pos--;
                 return ret;
             }
             /**
@@ -112,7 +628,7 @@ namespace sjtu
              */
             iterator &operator--()
             {
-                index--;
+                pos--;
                 return *this;
             }
             /**
@@ -120,29 +636,54 @@ namespace sjtu
              */
             T &operator*() const
             {
-                return vector_ptr->at(index);
+                return get(0);
+            }
+            T *operator->() const
+            {
+                return &get(0);
+            }
+            T &operator[](const int &n) const
+            {
+                return get(n);
             }
             /**
              * a operator to check whether two iterators are same (pointing to the same memory address).
              */
             bool operator==(const iterator &rhs) const
             {
-                return vector_ptr == rhs.vector_ptr && index == rhs.index;
+                return owner() == rhs.owner() && pos == rhs.pos;
             }
             bool operator==(const const_iterator &rhs) const
             {
-                return vector_ptr == rhs.vector_ptr && index == rhs.index;
+                return owner() == rhs.owner() && pos == rhs.pos;
             }
             /**
              * some other operator for iterator.
              */
             bool operator!=(const iterator &rhs) const
             {
-                return vector_ptr != rhs.vector_ptr || index != rhs.index;
+                return !(*this == rhs);
             }
             bool operator!=(const const_iterator &rhs) const
             {
-                return vector_ptr != rhs.vector_ptr || index != rhs.index;
+                return !(*this == rhs);
+            }
+            // NOTE: iterators of different vectors are unordered
+            bool operator<(const iterator &rhs) const
+            {
+                return pos < rhs.pos;
+            }
+            bool operator>(const iterator &rhs) const
+            {
+                return pos > rhs.pos;
+            }
+            bool operator<=(const iterator &rhs) const
+            {
+                return pos <= rhs.pos;
+            }
+            bool operator>=(const iterator &rhs) const
+            {
+                return pos >= rhs.pos;
             }
         };
         /**
@@ -151,48 +692,83 @@ namespace sjtu
          */
         class const_iterator
         {
+            friend class vector;
+            friend class iterator;
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const T *pointer;
+            typedef const T &reference;
+
         private:
-            const vector<T> *vector_ptr;
-            int index;
+#if SJTU_VECTOR_CHECKED
+            const vector *vector_ptr;
+            int pos;
+
+            const T &get(int n) const
+            {
+                return vector_ptr->at(pos + n);
+            }
+            const vector *owner() const
+            {
+                return vector_ptr;
+            }
+#else
+            const T *pos;
+
+            const T &get(int n) const
+            {
+                return pos[n];
+            }
+            const vector *owner() const
+            {
+                return nullptr;
+            }
+#endif
             /**
              * TODO add Data members
              *   just add whatever you want.
              */
         public:
-            const_iterator(const vector<T> *ptr, int idx) : vector_ptr(ptr), index(idx) {}
-            const_iterator(const const_iterator &other)
-            {
-                vector_ptr = other.vector_ptr;
-                index = other.index;
-            }
+#if SJTU_VECTOR_CHECKED
+            const_iterator(const vector *ptr, int idx) : vector_ptr(ptr), pos(idx) {}
+#else
+            const_iterator(const vector *ptr, int idx) : pos(ptr->storage + idx) {}
+#endif
             /**
              * return a new iterator which pointer n-next elements
              * as well as operator-
              */
             const_iterator operator+(const int &n) const
             {
-                return const_iterator(vector_ptr, index + n);
+                const_iterator ret(*this);
+                ret.pos += n;
+                return ret;
             }
             const_iterator operator-(const int &n) const
             {
-                return const_iterator(vector_ptr, index - n);
+                const_iterator ret(*this);
+                ret.pos -= n;
+                return ret;
             }
             // return the distance between two iterators,
             // if these two iterators point to different vectors, throw invalid_iterator.
             int operator-(const const_iterator &rhs) const
             {
-                if (vector_ptr != rhs.vector_ptr)
+                if (owner() != rhs.owner())
                     throw invalid_iterator();
-                return index - rhs.index;
+                return pos - rhs.pos;
             }
             const_iterator &operator+=(const int &n)
             {
-                index += n;
+                pos += n;
                 return *this;
             }
             const_iterator &operator-=(const int &n)
             {
-                index -= n;
+                pos -= n;
                 return *this;
             }
             /**
@@ -201,7 +777,7 @@ namespace sjtu
             const_iterator operator++(int)
             {
                 const_iterator ret(*this);
-                index++;
+                pos++;
                 return ret;
             }
             /**
@@ -209,7 +785,7 @@ namespace sjtu
              */
             const_iterator &operator++()
             {
-                index++;
+                pos++;
                 return *this;
             }
             /**
@@ -218,7 +794,7 @@ namespace sjtu
             const_iterator operator--(int)
             {
                 const_iterator ret(*this);
-                index--;
+                pos--;
                 return ret;
             }
             /**
@@ -226,7 +802,7 @@ namespace sjtu
              */
             const_iterator &operator--()
             {
-                index--;
+                pos--;
                 return *this;
             }
             /**
@@ -234,29 +810,53 @@ namespace sjtu
              */
             const T &operator*() const
             {
-                return vector_ptr->at(index);
+                return get(0);
+            }
+            const T *operator->() const
+            {
+                return &get(0);
+            }
+            const T &operator[](const int &n) const
+            {
+                return get(n);
             }
             /**
              * a operator to check whether two iterators are same (pointing to the same memory address).
              */
             bool operator==(const iterator &rhs) const
             {
-                return vector_ptr == rhs.vector_ptr && index == rhs.index;
+                return owner() == rhs.owner() && pos == rhs.pos;
             }
             bool operator==(const const_iterator &rhs) const
             {
-                return vector_ptr == rhs.vector_ptr && index == rhs.index;
+                return owner() == rhs.owner() && pos == rhs.pos;
             }
             /**
              * some other operator for iterator.
              */
             bool operator!=(const iterator &rhs) const
             {
-                return vector_ptr != rhs.vector_ptr || index != rhs.index;
+                return !(*this == rhs);
             }
             bool operator!=(const const_iterator &rhs) const
             {
-                return vector_ptr != rhs.vector_ptr || index != rhs.index;
+                return !(*this == rhs);
+            }
+            bool operator<(const const_iterator &rhs) const
+            {
+                return pos < rhs.pos;
+            }
+            bool operator>(const const_iterator &rhs) const
+            {
+                return pos > rhs.pos;
+            }
+            bool operator<=(const const_iterator &rhs) const
+            {
+                return pos <= rhs.pos;
+            }
+            bool operator>=(const const_iterator &rhs) const
+            {
+                return pos >= rhs.pos;
             }
         };
         /**
@@ -264,46 +864,74 @@ namespace sjtu
          * Atleast two: default constructor, copy constructor
          */
         vector()
+            : storage(nullptr), current_size(0), max_size(0), inline_storage(nullptr), inline_size(0) {}
+        explicit vector(const Allocator &alloc)
+            : storage(nullptr), current_size(0), max_size(0),
+              inline_storage(nullptr), inline_size(0), alloc(alloc) {}
+        vector(const vector &other)
+            : inline_storage(nullptr), inline_size(0),
+              alloc(alloc_traits::select_on_container_copy_construction(other.alloc))
         {
-            current_size = 0;
-            max_size = 1;
-            storage = new T *[max_size];
+            copyFrom(other);
         }
-        vector(const vector &other)
+        vector(const vector &other, const Allocator &alloc)
+            : inline_storage(nullptr), inline_size(0), alloc(alloc)
         {
-            max_size = other.max_size;
-            current_size = other.current_size;
-            storage = new T *[max_size];
-            for (int i = 0; i < current_size; ++i)
-                storage[i] = new T(*other.storage[i]);
+            copyFrom(other);
+        }
+        // NOTE: the elements of a small_vector on its inline buffer are moved one by one,
+        //  and a copy that throws there terminates
+        vector(vector &&other) noexcept
+            : storage(nullptr), current_size(0), max_size(0),
+              inline_storage(nullptr), inline_size(0), alloc(std::move(other.alloc))
+        {
+            steal(other);
         }
         /**
          * TODO Destructor
          */
         ~vector()
         {
-            for (int i = 0; i < current_size; ++i)
-                delete storage[i];
-            delete[] storage;
+            destroy(storage, storage + current_size);
+            deallocate(storage, max_size);
         }
         /**
          * TODO Assignment operator
          */
+        // NOTE: as std::vector, the allocator of other is taken
+        //  only if propagate_on_container_copy_assignment,
+        //  and the buffer is reused if large enough, where a throwing copy leaves this empty
         vector &operator=(const vector &other)
         {
-            if (this != &other)
+            if (this == &other)
+                return *this;
+            bool is_taken = alloc_traits::propagate_on_container_copy_assignment::value &&
+                            !(alloc == other.alloc);
+            if (!is_taken && other.current_size <= max_size)
             {
-                for (int i = 0; i < current_size; ++i)
-                    delete storage[i];
-                delete[] storage;
-                max_size = other.max_size;
+                clear();
+                construct(other.storage, other.current_size, storage);
                 current_size = other.current_size;
-                storage = new T *[max_size];
-                for (int i = 0; i < current_size; ++i)
-                    storage[i] = new T(*other.storage[i]);
+                return *this;
             }
+            vector copy(other, is_taken ? other.alloc : alloc);
+            release();
+            if (is_taken)
+                alloc = copy.alloc;
+            steal(copy);
+            return *this;
+        }
+        vector &operator=(vector &&other) noexcept(
+            alloc_traits::propagate_on_container_move_assignment::value)
+        {
+            if (this != &other)
+                moveAssign(other, typename alloc_traits::propagate_on_container_move_assignment());
             return *this;
         }
+        allocator_type get_allocator() const
+        {
+            return alloc;
+        }
         /**
          * assigns specified element with bounds checking
          * throw index_out_of_bound if pos is not in [0, size)
@@ -312,13 +940,13 @@ namespace sjtu
         {
             if (pos < 0 || pos >= current_size)
                 throw index_out_of_bound();
-            return *storage[pos];
+            return storage[pos];
         }
         const T &at(const size_t &pos) const
         {
             if (pos < 0 || pos >= current_size)
                 throw index_out_of_bound();
-            return *storage[pos];
+            return storage[pos];
         }
         /**
          * assigns specified element with bounds checking
@@ -326,17 +954,18 @@ namespace sjtu
          * !!! Pay attentions
          *   In STL this operator does not check the boundary but I want you to do.
          */
+        // NOTE: unless SJTU_VECTOR_CHECKED is 0
         T &operator[](const size_t &pos)
         {
-            if (pos < 0 || pos >= current_size)
+            if (SJTU_VECTOR_CHECKED && pos >= (size_t)current_size)
                 throw index_out_of_bound();
-            return *storage[pos];
+            return storage[pos];
         }
         const T &operator[](const size_t &pos) const
         {
-            if (pos < 0 || pos >= current_size)
+            if (SJTU_VECTOR_CHECKED && pos >= (size_t)current_size)
                 throw index_out_of_bound();
-            return *storage[pos];
+            return storage[pos];
         }
         /**
          * access the first element.
@@ -346,7 +975,7 @@ namespace sjtu
         {
             if (empty())
                 throw container_is_empty();
-            return *storage[0];
+            return storage[0];
         }
         /**
          * access the last element.
@@ -356,7 +985,19 @@ namespace sjtu
         {
             if (empty())
                 throw container_is_empty();
-            return *storage[current_size - 1];
+            return storage[current_size - 1];
+        }
+        /**
+         * the underlying buffer, whose [0, size) are the elements
+         */
+        // NOTE: invalidated by a reallocation, as std::vector's
+        T *data()
+        {
+            return storage;
+        }
+        const T *data() const
+        {
+            return storage;
         }
         /**
          * returns an iterator to the beginning.
@@ -399,12 +1040,8 @@ namespace sjtu
          */
         void clear()
         {
-            for (int i = 0; i < current_size; ++i)
-                delete storage[i];
-            delete[] storage;
+            destroy(storage, storage + current_size);
             current_size = 0;
-            max_size = 1;
-            storage = new T *[max_size];
         }
         /**
          * inserts value before pos
@@ -412,7 +1049,11 @@ namespace sjtu
          */
         iterator insert(iterator pos, const T &value)
         {
-            return insert(pos.iterator_pos(), value);
+            return insert(pos.index(this), value);
+        }
+        iterator insert(iterator pos, T &&value)
+        {
+            return insert(pos.index(this), std::move(value));
         }
         /**
          * inserts value at index ind.
@@ -424,21 +1065,73 @@ namespace sjtu
         {
             if (ind < 0 || ind > current_size)
                 throw index_out_of_bound();
-
-            if (current_size == max_size)
+            emplaceAt(ind, value);
+            return iterator(this, ind);
+        }
+        iterator insert(const size_t &ind, T &&value)
+        {
+            if (ind > (size_t)current_size)
+                throw index_out_of_bound();
+            emplaceAt(ind, std::move(value));
+            return iterator(this, ind);
+        }
+        /**
+         * inserts [first, last) before pos, growing at most once and shifting the tail once.
+         * first and last should not be iterators into this vector.
+         * returns an iterator pointing to the first inserted value, or pos if none.
+         * throw index_out_of_bound if pos is not in [begin, end]
+         */
+        // NOTE: a single pass range is collected into a temporary vector first
+        template <class InputIt,
+                  class = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+        iterator insert(iterator pos, InputIt first, InputIt last)
+        {
+            int ind = pos.index(this);
+            if (ind < 0 || ind > current_size)
+                throw index_out_of_bound();
+            insertAt(ind, first, last, typename std::iterator_traits<InputIt>::iterator_category());
+            return iterator(this, ind);
+        }
+        /**
+         * inserts count copies of value before pos, as above.
+         */
+        iterator insert(iterator pos, const size_t &count, const T &value)
+        {
+            int ind = pos.index(this);
+            if (ind < 0 || ind > current_size)
+                throw index_out_of_bound();
+            if (count > 0)
             {
-                T **old_storage = storage;
-                max_size <<= 1;
-                storage = new T *[max_size];
-                for (int i = 0; i < current_size; ++i)
-                    storage[i] = old_storage[i];
-                delete[] old_storage;
+                // value may be shifted away
+                T copy(value);
+                insertAt(ind, Repeat{&copy}, count);
             }
-
-            for (int i = current_size; i > ind; --i)
-                storage[i] = storage[i - 1];
-            storage[ind] = new T(value);
-            current_size++;
+            return iterator(this, ind);
+        }
+        /**
+         * replaces the contents with [first, last), growing at most once.
+         * first and last should not be iterators into this vector.
+         */
+        template <class InputIt,
+                  class = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+        void assign(InputIt first, InputIt last)
+        {
+            clear();
+            insertAt(0, first, last, typename std::iterator_traits<InputIt>::iterator_category());
+        }
+        /**
+         * constructs T(args...) before pos
+         * returns an iterator pointing to the new element.
+         */
+        // NOTE: as every insert, this is unchanged if it throws,
+        //  except for a move only T whose move may throw, see emplaceAt
+        template <class... Args>
+        iterator emplace(iterator pos, Args &&... args)
+        {
+            int ind = pos.index(this);
+            if (ind < 0 || ind > current_size)
+                throw index_out_of_bound();
+            emplaceAt(ind, std::forward<Args>(args)...);
             return iterator(this, ind);
         }
         /**
@@ -448,7 +1141,7 @@ namespace sjtu
          */
         iterator erase(iterator pos)
         {
-            return erase(pos.iterator_pos());
+            return erase(pos.index(this));
         }
         /**
          * removes the element with index ind.
@@ -459,10 +1152,20 @@ namespace sjtu
         {
             if (ind < 0 || ind >= current_size)
                 throw index_out_of_bound();
-            delete storage[ind];
-            for (int i = ind; i < current_size - 1; i++)
-                storage[i] = storage[i + 1];
-            current_size--;
+            eraseAt(ind, 1);
+            return iterator(this, ind);
+        }
+        /**
+         * removes the elements in [first, last), shifting the tail once.
+         * return an iterator pointing to the element following them.
+         * throw index_out_of_bound if [first, last) is not a range in [0, size)
+         */
+        iterator erase(iterator first, iterator last)
+        {
+            int ind = first.index(this), n = last.index(this) - ind;
+            if (ind < 0 || n < 0 || ind + n > current_size)
+                throw index_out_of_bound();
+            eraseAt(ind, n);
             return iterator(this, ind);
         }
         /**
@@ -470,16 +1173,21 @@ namespace sjtu
          */
         void push_back(const T &value)
         {
-            if (current_size == max_size)
-            {
-                T **old_storage = storage;
-                max_size <<= 1;
-                storage = new T *[max_size];
-                for (int i = 0; i < current_size; ++i)
-                    storage[i] = old_storage[i];
-                delete[] old_storage;
-            }
-            storage[current_size++] = new T(value);
+            emplaceAt(current_size, value);
+        }
+        void push_back(T &&value)
+        {
+            emplaceAt(current_size, std::move(value));
+        }
+        /**
+         * constructs T(args...) at the end.
+         * returns a reference to it.
+         */
+        template <class... Args>
+        T &emplace_back(Args &&... args)
+        {
+            emplaceAt(current_size, std::forward<Args>(args)...);
+            return storage[current_size - 1];
         }
         /**
          * remove the last element from the end.
@@ -489,7 +1197,8 @@ namespace sjtu
         {
             if (empty())
                 throw container_is_empty();
-            delete storage[--current_size];
+            current_size--;
+            destroy(storage + current_size, storage + current_size + 1);
         }
     };
 